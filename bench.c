@@ -0,0 +1,400 @@
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "perf.h"
+#include "sample.h"
+#include "vmm.h"
+#include "workload.h"
+
+
+/* Global Constants */
+#define CHUNK_SIZE          16384
+#define NUM_POLICIES        2
+#ifndef BENCH_BUILD_FLAGS
+#define BENCH_BUILD_FLAGS   "unknown"
+#endif
+
+/* Struct Type Prototypes */
+typedef struct BenchOptions BenchOptions;
+typedef struct BenchResult BenchResult;
+
+/* Function Prototypes */
+static void usage(char *);
+static int parseOptions(int, char **, BenchOptions *);
+static int runBenchmark(BenchOptions *, WorkloadType, ReplacementPolicy, BenchResult *);
+static int runSampledBenchmark(BenchOptions *, WorkloadType, ReplacementPolicy, BenchResult *);
+static void resetPeakRSS(void);
+static long getPeakRSS(void);
+static int isFaultRateCovered(BenchResult *);
+static int isTLBHitRateCovered(BenchResult *);
+static double elapsedSeconds(struct timespec *, struct timespec *);
+static void printResult(FILE *, BenchResult *, int);
+
+
+/********** Bench Definitions **********/
+
+typedef struct BenchOptions {
+    uint64_t references;
+    int numFrames;
+    int TLBSize;
+    uint64_t seed;
+    const char *backingStorePath;
+    const char *outputPath;
+    double sampleRate;
+    int workloads[NUM_WORKLOADS];
+    int policies[NUM_POLICIES];
+} BenchOptions;
+
+typedef struct BenchResult {
+    WorkloadType workload;
+    ReplacementPolicy policy;
+    VirtualMemoryStatistics stats;
+    double seconds;
+    double perCallSeconds;      // the same stream through translateAddress
+    long peakRSS;
+    int hasCacheMisses;
+    uint64_t cacheMisses;
+    int hasEstimate;
+    SampledEstimate estimate;
+    double sampledSeconds;
+} BenchResult;
+
+static const ReplacementPolicy policies[NUM_POLICIES] = { FIFO_REPLACEMENT, LRU_REPLACEMENT };
+
+
+/*********** MAIN ***********/
+int main(int argc, char **argv) {
+    BenchOptions options;
+    if (!parseOptions(argc, argv, &options)) {
+        usage(argv[0]);
+        exit(1);
+    }
+    FILE *out = stdout;
+    if (options.outputPath != 0) {
+        out = fopen(options.outputPath, "w");
+        if (out == 0) {
+            fprintf(stderr, "Error: Cannot open %s for writing!\n", options.outputPath);
+            exit(1);
+        }
+    }
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"references\": %" PRIu64 ",\n", options.references);
+    fprintf(out, "  \"frames\": %d,\n", options.numFrames);
+    fprintf(out, "  \"tlb_size\": %d,\n", options.TLBSize);
+    fprintf(out, "  \"seed\": %" PRIu64 ",\n", options.seed);
+    fprintf(out, "  \"build_flags\": \"%s\",\n", BENCH_BUILD_FLAGS);
+    fprintf(out, "  \"results\": [");
+    int first = 1;
+    int estimates = 0;
+    int insufficient = 0;
+    int faultRatesCovered = 0;
+    int TLBHitRatesCovered = 0;
+    for (int w = 0; w < NUM_WORKLOADS; ++w) {
+        if (!options.workloads[w]) continue;
+        for (int p = 0; p < NUM_POLICIES; ++p) {
+            if (!options.policies[p]) continue;
+            BenchResult result;
+            if (!runBenchmark(&options, w, policies[p], &result)
+                    || !runSampledBenchmark(&options, w, policies[p], &result)) {
+                fprintf(stderr, "Error: Cannot open %s for reading binary!\n", options.backingStorePath);
+                exit(1);
+            }
+            printResult(out, &result, first);
+            first = 0;
+            if (result.hasEstimate && result.estimate.isInsufficient) {
+                insufficient++;
+            } else if (result.hasEstimate) {
+                estimates++;
+                faultRatesCovered += isFaultRateCovered(&result);
+                TLBHitRatesCovered += isTLBHitRateCovered(&result);
+            }
+            fflush(out);
+        }
+    }
+    fprintf(out, "\n  ]");
+    if (estimates + insufficient > 0) {
+        // How often the sampled bounds actually held against the full runs,
+        // leaving out the runs whose sample was reported as insufficient
+        double total = estimates > 0 ? estimates : 1;
+        fprintf(out, ",\n  \"sample_coverage\": {\"estimates\": %d, \"insufficient\": %d, \"fault_rate\": %.3f, \"tlb_hit_rate\": %.3f}",
+                estimates, insufficient, faultRatesCovered / total, TLBHitRatesCovered / total);
+    }
+    fprintf(out, "\n}\n");
+
+    if (out != stdout) fclose(out);
+    return 0;
+}
+
+
+/*********** Function Definitions ***********/
+
+static void usage(char *name) {
+    fprintf(stderr, "Usage: %s [-n references] [-w workload[,workload...]] [-p fifo|lru|all]\n", name);
+    fprintf(stderr, "          [-f frames] [-t tlbsize] [-s seed] [-b backingstore] [-o output.json]\n");
+    fprintf(stderr, "          [-r samplerate]\n");
+    fprintf(stderr, "Workloads: all");
+    for (int i = 0; i < NUM_WORKLOADS; ++i) {
+        fprintf(stderr, " %s", getWorkloadName(i));
+    }
+    fprintf(stderr, "\n");
+}
+
+static int parseOptions(int argc, char **argv, BenchOptions *options) {
+    options->references = 1000000;
+    options->numFrames = 128;
+    options->TLBSize = 16;
+    options->seed = 42;
+    options->backingStorePath = VMM_BACKING_STORE;
+    options->outputPath = 0;
+    options->sampleRate = 0;
+    for (int i = 0; i < NUM_WORKLOADS; ++i) options->workloads[i] = 1;
+    for (int i = 0; i < NUM_POLICIES; ++i) options->policies[i] = 1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:w:p:f:t:s:b:o:r:")) != -1) {
+        switch (opt) {
+            case 'n':
+                // accept 1e9 style counts
+                options->references = (uint64_t)strtod(optarg, 0);
+                break;
+            case 'w':
+                if (strcmp(optarg, "all") == 0) break;
+                for (int i = 0; i < NUM_WORKLOADS; ++i) options->workloads[i] = 0;
+                for (char *name = strtok(optarg, ","); name != 0; name = strtok(0, ",")) {
+                    WorkloadType type;
+                    if (!parseWorkloadType(name, &type)) return 0;
+                    options->workloads[type] = 1;
+                }
+                break;
+            case 'p':
+                if (strcmp(optarg, "all") == 0) break;
+                for (int i = 0; i < NUM_POLICIES; ++i) {
+                    options->policies[i] = strcmp(optarg, getReplacementPolicyName(policies[i])) == 0;
+                }
+                if (!options->policies[0] && !options->policies[1]) return 0;
+                break;
+            case 'f':
+                options->numFrames = atoi(optarg);
+                break;
+            case 't':
+                options->TLBSize = atoi(optarg);
+                break;
+            case 's':
+                options->seed = strtoull(optarg, 0, 10);
+                break;
+            case 'b':
+                options->backingStorePath = optarg;
+                break;
+            case 'o':
+                options->outputPath = optarg;
+                break;
+            case 'r':
+                options->sampleRate = atof(optarg);
+                if (options->sampleRate <= 0 || options->sampleRate > 1) return 0;
+                break;
+            default:
+                return 0;
+        }
+    }
+    return optind == argc && options->references > 0;
+}
+
+static int runBenchmark(BenchOptions *options, WorkloadType type, ReplacementPolicy policy, BenchResult *result) {
+    VirtualMemoryConfig config;
+    config.size = sizeof(config);
+    initVirtualMemoryConfig(&config, policy);
+    config.numFrames = options->numFrames;
+    config.TLBSize = options->TLBSize;
+    config.backingStorePath = options->backingStorePath;
+    WorkloadConfig workloadConfig;
+    initWorkloadConfig(&workloadConfig, type);
+    workloadConfig.seed = options->seed;
+
+    resetPeakRSS();
+    VirtualMemory *vm = newVirtualMemory(&config);
+    if (vm == 0) return 0;
+    // A second instance takes every chunk one translateAddress call at a
+    // time, alternating with the batch so both see the same conditions
+    VirtualMemory *perCallVm = newVirtualMemory(&config);
+    if (perCallVm == 0) {
+        freeVirtualMemory(vm);
+        return 0;
+    }
+    Workload *workload = newWorkload(&workloadConfig);
+    PerfCounters *counters = newPerfCounters();
+    uint64_t *addresses = malloc(sizeof(uint64_t) * CHUNK_SIZE);
+    uint32_t *physicalAddresses = malloc(sizeof(uint32_t) * CHUNK_SIZE);
+    int *values = malloc(sizeof(int) * CHUNK_SIZE);
+
+    // Only the translations are timed and counted, not the generator
+    result->seconds = 0;
+    result->perCallSeconds = 0;
+    for (uint64_t done = 0; done < options->references; ) {
+        size_t count = options->references - done < CHUNK_SIZE ? options->references - done : CHUNK_SIZE;
+        fillWorkload(workload, addresses, count);
+        struct timespec start, end;
+        startPerfCounters(counters);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        translateBatch(vm, addresses, count, physicalAddresses, values);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        stopPerfCounters(counters);
+        result->seconds += elapsedSeconds(&start, &end);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (size_t i = 0; i < count; ++i) {
+            translateAddress(perCallVm, addresses[i], &physicalAddresses[i], &values[i]);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        result->perCallSeconds += elapsedSeconds(&start, &end);
+        done += count;
+    }
+
+    result->workload = type;
+    result->policy = policy;
+    result->stats.size = sizeof(result->stats);
+    getVirtualMemoryStatistics(vm, &result->stats);
+    result->peakRSS = getPeakRSS();
+    result->hasCacheMisses = readPerfCounter(counters, PERF_CACHE_MISSES, &result->cacheMisses);
+
+    free(addresses);
+    free(physicalAddresses);
+    free(values);
+    freePerfCounters(counters);
+    freeWorkload(workload);
+    freeVirtualMemory(vm);
+    freeVirtualMemory(perCallVm);
+    return 1;
+}
+
+static int runSampledBenchmark(BenchOptions *options, WorkloadType type, ReplacementPolicy policy, BenchResult *result) {
+    // Replays the same generated stream through the sampled simulator so
+    // the estimate can be checked against the full run
+    result->hasEstimate = 0;
+    if (options->sampleRate <= 0) return 1;
+    VirtualMemoryConfig config;
+    config.size = sizeof(config);
+    initVirtualMemoryConfig(&config, policy);
+    config.numFrames = options->numFrames;
+    config.TLBSize = options->TLBSize;
+    config.backingStorePath = options->backingStorePath;
+    WorkloadConfig workloadConfig;
+    initWorkloadConfig(&workloadConfig, type);
+    workloadConfig.seed = options->seed;
+
+    SampledSimulation *sim = newSampledSimulation(&config, options->sampleRate, options->seed);
+    if (sim == 0) return 0;
+    Workload *workload = newWorkload(&workloadConfig);
+    uint64_t *addresses = malloc(sizeof(uint64_t) * CHUNK_SIZE);
+    result->sampledSeconds = 0;
+    for (uint64_t done = 0; done < options->references; ) {
+        size_t count = options->references - done < CHUNK_SIZE ? options->references - done : CHUNK_SIZE;
+        fillWorkload(workload, addresses, count);
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        sampleBatch(sim, addresses, count);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        result->sampledSeconds += elapsedSeconds(&start, &end);
+        done += count;
+    }
+    getSampledEstimate(sim, &result->estimate);
+    result->hasEstimate = 1;
+
+    free(addresses);
+    freeWorkload(workload);
+    freeSampledSimulation(sim);
+    return 1;
+}
+
+static void resetPeakRSS(void) {
+    // Linux resets VmHWM to the current RSS when 5 is written here
+    FILE *fp = fopen("/proc/self/clear_refs", "w");
+    if (fp == 0) return;
+    fputs("5", fp);
+    fclose(fp);
+}
+
+static long getPeakRSS(void) {
+    FILE *fp = fopen("/proc/self/status", "r");
+    if (fp != 0) {
+        char *line = 0;
+        size_t len = 0;
+        long peak = -1;
+        while (getline(&line, &len, fp) != -1) {
+            if (sscanf(line, "VmHWM: %ld", &peak) == 1) break;
+        }
+        free(line);
+        fclose(fp);
+        if (peak != -1) return peak;
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static int isFaultRateCovered(BenchResult *r) {
+    double actual = (double)r->stats.numPageFaults / r->stats.numTranslated;
+    return actual >= r->estimate.faultRateLow && actual <= r->estimate.faultRateHigh;
+}
+
+static int isTLBHitRateCovered(BenchResult *r) {
+    double actual = (double)r->stats.numTLBhits / r->stats.numTranslated;
+    return actual >= r->estimate.TLBHitRateLow && actual <= r->estimate.TLBHitRateHigh;
+}
+
+static double elapsedSeconds(struct timespec *start, struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void printResult(FILE *fp, BenchResult *r, int first) {
+    VirtualMemoryStatistics *s = &r->stats;
+    double seconds = r->seconds > 0 ? r->seconds : 1e-9;
+    fprintf(fp, "%s\n    {", first ? "" : ",");
+    fprintf(fp, "\"workload\": \"%s\", ", getWorkloadName(r->workload));
+    fprintf(fp, "\"policy\": \"%s\", ", getReplacementPolicyName(r->policy));
+    fprintf(fp, "\"references\": %" PRIu64 ", ", s->numTranslated);
+    fprintf(fp, "\"seconds\": %.6f, ", r->seconds);
+    fprintf(fp, "\"references_per_second\": %.0f, ", s->numTranslated / seconds);
+    fprintf(fp, "\"ns_per_translation\": %.3f, ", seconds * 1e9 / s->numTranslated);
+    fprintf(fp, "\"per_call_ns_per_translation\": %.3f, ", r->perCallSeconds * 1e9 / s->numTranslated);
+    fprintf(fp, "\"batch_speedup\": %.2f, ", r->perCallSeconds / seconds);
+    fprintf(fp, "\"page_faults\": %" PRIu64 ", ", s->numPageFaults);
+    fprintf(fp, "\"fault_rate\": %.6f, ", (double)s->numPageFaults / s->numTranslated);
+    fprintf(fp, "\"faults_per_second\": %.0f, ", s->numPageFaults / seconds);
+    fprintf(fp, "\"tlb_hits\": %" PRIu64 ", ", s->numTLBhits);
+    fprintf(fp, "\"tlb_hit_rate\": %.6f, ", (double)s->numTLBhits / s->numTranslated);
+    fprintf(fp, "\"evictions\": %" PRIu64 ", ", s->numEvictions);
+    fprintf(fp, "\"peak_rss_kb\": %ld, ", r->peakRSS);
+    if (r->hasCacheMisses) fprintf(fp, "\"cache_misses\": %" PRIu64, r->cacheMisses);
+    else                   fprintf(fp, "\"cache_misses\": null");
+    if (r->hasEstimate) {
+        SampledEstimate *e = &r->estimate;
+        double sampledSeconds = r->sampledSeconds > 0 ? r->sampledSeconds : 1e-9;
+        fprintf(fp, ", \"sample\": {");
+        fprintf(fp, "\"rate\": %.4f, ", e->rate);
+        fprintf(fp, "\"frames\": %d, ", e->numFrames);
+        fprintf(fp, "\"tlb_size\": %d, ", e->TLBSize);
+        fprintf(fp, "\"working_set\": %d, ", e->workingSet);
+        fprintf(fp, "\"insufficient\": %s, ", e->isInsufficient ? "true" : "false");
+        fprintf(fp, "\"seconds\": %.6f, ", r->sampledSeconds);
+        fprintf(fp, "\"speedup\": %.2f, ", seconds / sampledSeconds);
+        fprintf(fp, "\"fault_rate\": %.6f, ", e->faultRate);
+        fprintf(fp, "\"fault_rate_bounds\": [%.6f, %.6f], ", e->faultRateLow, e->faultRateHigh);
+        fprintf(fp, "\"fault_rate_abs_diff\": %.6f, ", fabs(e->faultRate - (double)s->numPageFaults / s->numTranslated));
+        fprintf(fp, "\"fault_rate_covered\": %s, ", isFaultRateCovered(r) ? "true" : "false");
+        fprintf(fp, "\"tlb_hit_rate\": %.6f, ", e->TLBHitRate);
+        fprintf(fp, "\"tlb_hit_rate_bounds\": [%.6f, %.6f], ", e->TLBHitRateLow, e->TLBHitRateHigh);
+        fprintf(fp, "\"tlb_hit_rate_abs_diff\": %.6f, ", fabs(e->TLBHitRate - (double)s->numTLBhits / s->numTranslated));
+        fprintf(fp, "\"tlb_hit_rate_covered\": %s}", isTLBHitRateCovered(r) ? "true" : "false");
+    }
+    fprintf(fp, "}");
+}
@@ -0,0 +1,548 @@
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <getopt.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cli.h"
+#include "interval.h"
+#include "sample.h"
+
+
+/* Global Constants */
+#define BATCH_SIZE          VMM_BATCH_SIZE
+#define INTERVAL_CAPACITY   4096
+
+/* Struct Type Prototypes */
+typedef struct CLIOptions CLIOptions;
+typedef struct TraceRun TraceRun;
+
+/* Function Prototypes */
+static void usage(char *);
+static int parseOptions(int, char **, CLIOptions *);
+static FILE *openFile(char *, char *);
+static uint64_t parseAddress(char *);
+static int parseNodes(char *, CLIOptions *);
+static void handleInterrupt(int);
+static void saveCheckpoint(VirtualMemory *, char *, FILE *);
+static int runSampledSimulator(CLIOptions *, VirtualMemoryConfig *, FILE *);
+static void printTranslations(FILE *, VirtualMemory *, Profile *, const uint64_t *, size_t);
+
+/* TraceRun Function Prototypes */
+static void initTraceRun(TraceRun *, int);
+static void addTraceRunAddress(TraceRun *, FILE *, VirtualMemory *, VirtualMemory *, uint64_t);
+static void flushTraceRun(TraceRun *, FILE *, VirtualMemory *, VirtualMemory *);
+static void freeTraceRun(TraceRun *);
+
+
+/********** CLIOptions Definitions **********/
+
+typedef struct CLIOptions {
+    char *addressPath;
+    char *backingStorePath;
+    int profiling;
+    uint64_t intervalReferences;
+    uint64_t intervalQuantum;
+    char *intervalPath;
+    IntervalFormat intervalFormat;
+    char *checkpointPath;
+    uint64_t checkpointEvery;
+    char *restorePath;
+    int fromStart;
+    double sampleRate;
+    uint64_t sampleSeed;
+    size_t compressedPoolBytes;
+    int deduplicate;
+    int numNodes;
+    int nodeFrames[VMM_MAX_NODES];
+    uint64_t nodeLatency[VMM_MAX_NODES];
+    PlacementPolicy placement;
+    uint64_t migrationPeriod;
+    int compact;
+    int expand;
+} CLIOptions;
+
+// Consecutive references to one page with the same access kind, translated
+// as a single (page, count) record
+typedef struct TraceRun {
+    uint64_t first;
+    size_t length;
+    int expand;             // keep every address to print each access afterwards
+    uint64_t *addresses;    // BATCH_SIZE of them when expanding
+} TraceRun;
+
+// Set from the signal handler so a run stops at the next batch boundary
+static volatile sig_atomic_t interrupted = 0;
+
+
+/*********** Simulator ***********/
+int runSimulator(int argc, char **argv, ReplacementPolicy policy, int numFrames) {
+    CLIOptions options;
+    if (!parseOptions(argc, argv, &options)) {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    // Open Files for reading
+    FILE *addressesFile = openFile(options.addressPath, "r");
+
+    // Create PageTable, PhysicalMemory, and TLB
+    VirtualMemoryConfig config;
+    config.size = sizeof(config);
+    initVirtualMemoryConfig(&config, policy);
+    config.numFrames = numFrames;
+    config.backingStorePath = options.backingStorePath;
+    config.compressedPoolBytes = options.compressedPoolBytes;
+    config.deduplicate = options.deduplicate;
+    if (options.numNodes > 1) {
+        // The node sizes replace the program's own frame count
+        config.numNodes = options.numNodes;
+        config.numFrames = 0;
+        for (int i = 0; i < options.numNodes; ++i) {
+            config.nodeFrames[i] = options.nodeFrames[i];
+            config.nodeLatency[i] = options.nodeLatency[i];
+            config.numFrames += options.nodeFrames[i];
+        }
+        config.placement = options.placement;
+        if (options.migrationPeriod > 0) config.migrationPeriod = options.migrationPeriod;
+    }
+    if (options.sampleRate > 0) return runSampledSimulator(&options, &config, addressesFile);
+    VirtualMemory *vm = 0;
+    if (options.restorePath != 0) {
+        uint64_t traceOffset = 0;
+        vm = restoreVirtualMemory(options.restorePath, config.backingStorePath, &traceOffset);
+        if (vm == 0) {
+            fprintf(stderr, "Error: Cannot restore checkpoint %s!\n", options.restorePath);
+            exit(1);
+        }
+        if (!options.fromStart) fseek(addressesFile, (long)traceOffset, SEEK_SET);
+    }
+    else {
+        vm = newVirtualMemory(&config);
+    }
+    if (vm == 0) {
+        fprintf(stderr, "Error: Cannot open %s for reading binary!\n", config.backingStorePath);
+        exit(1);
+    }
+    // A fresh run alongside without merging, or with pages interleaved
+    // across nodes, gives what dedup or placement saves
+    VirtualMemory *baseline = 0;
+    if (options.restorePath == 0 && (options.deduplicate || (options.numNodes > 1 && options.placement != INTERLEAVE_PLACEMENT))) {
+        VirtualMemoryConfig baselineConfig = config;
+        baselineConfig.deduplicate = 0;
+        baselineConfig.placement = INTERLEAVE_PLACEMENT;
+        baseline = newVirtualMemory(&baselineConfig);
+    }
+    if (options.checkpointPath != 0) {
+        signal(SIGINT, handleInterrupt);
+        signal(SIGTERM, handleInterrupt);
+    }
+    VirtualMemoryStatistics stats;
+    stats.size = sizeof(stats);
+    getVirtualMemoryStatistics(vm, &stats);
+    uint64_t nextCheckpoint = options.checkpointEvery > 0 ? stats.numTranslated + options.checkpointEvery : UINT64_MAX;
+    Profile *profile = 0;
+    if (options.profiling) {
+#ifndef VMM_PROFILE
+        fprintf(stderr, "Warning: profiling hooks were compiled out (PROFILE=0)\n");
+#endif
+        profile = newProfile(1);
+        setVirtualMemoryProfile(vm, profile);
+    }
+    FILE *intervalFile = 0;
+    IntervalSampler *sampler = 0;
+    if (options.intervalReferences > 0 || options.intervalQuantum > 0) {
+        intervalFile = fopen(options.intervalPath, options.intervalFormat == BINARY_INTERVALS ? "wb" : "w");
+        if (intervalFile == 0) {
+            fprintf(stderr, "Error: Cannot open %s for writing!\n", options.intervalPath);
+            exit(1);
+        }
+        sampler = newIntervalSampler(intervalFile, options.intervalFormat, options.intervalReferences, options.intervalQuantum, INTERVAL_CAPACITY);
+        if (sampler == 0) {
+            fprintf(stderr, "Error: Cannot start the interval writer for %s!\n", options.intervalPath);
+            exit(1);
+        }
+        setVirtualMemorySampler(vm, sampler);
+    }
+
+    // Perform Translations one batch at a time, or one run at a time when compacting
+    uint64_t virtualAddresses[BATCH_SIZE];
+    size_t count = 0;
+    char *line = 0;
+    size_t len = 0;
+    TraceRun run;
+    initTraceRun(&run, options.expand);
+    PROFILE_MARK(profile, mark);
+    while (!interrupted && getline(&line, &len, addressesFile) != -1) {
+        // Get Logical Address from Addresses File
+        if (options.compact) {
+            addTraceRunAddress(&run, stdout, vm, baseline, parseAddress(line));
+            continue;
+        }
+        virtualAddresses[count++] = parseAddress(line);
+        if (count == BATCH_SIZE) {
+            PROFILE_SAMPLES(profile, PARSE_PHASE, mark, count);
+            printTranslations(stdout, vm, profile, virtualAddresses, count);
+            if (baseline != 0) translateBatch(baseline, virtualAddresses, count, 0, 0);
+            count = 0;
+            getVirtualMemoryStatistics(vm, &stats);
+            if (stats.numTranslated >= nextCheckpoint) {
+                saveCheckpoint(vm, options.checkpointPath, addressesFile);
+                nextCheckpoint = stats.numTranslated + options.checkpointEvery;
+            }
+            PROFILE_RESET(profile, mark);
+        }
+    }
+    PROFILE_SAMPLES(profile, PARSE_PHASE, mark, count);
+    printTranslations(stdout, vm, profile, virtualAddresses, count);
+    if (baseline != 0) translateBatch(baseline, virtualAddresses, count, 0, 0);
+    flushTraceRun(&run, stdout, vm, baseline);
+    freeTraceRun(&run);
+    if (interrupted) fprintf(stderr, "Interrupted, saving checkpoint to %s\n", options.checkpointPath);
+    if (options.checkpointPath != 0) saveCheckpoint(vm, options.checkpointPath, addressesFile);
+
+    // Flush the final partial interval
+    if (sampler != 0) {
+        sampleVirtualMemory(vm);
+        setVirtualMemorySampler(vm, 0);
+        if (getIntervalSamplerDropped(sampler) > 0) {
+            fprintf(stderr, "Warning: %llu interval samples dropped\n", (unsigned long long)getIntervalSamplerDropped(sampler));
+        }
+        freeIntervalSampler(sampler);
+        fclose(intervalFile);
+    }
+
+    // Display Statistics, by what the instance runs with since a restored
+    // checkpoint carries its own configuration whatever the flags say
+    VirtualMemoryConfig running;
+    running.size = sizeof(running);
+    getVirtualMemoryConfig(vm, &running);
+    getVirtualMemoryStatistics(vm, &stats);
+    printStatistics(stdout, &stats);
+    if (running.compressedPoolBytes > 0) printTierStatistics(stdout, &stats);
+    if (running.deduplicate) {
+        VirtualMemoryStatistics baselineStats;
+        baselineStats.size = sizeof(baselineStats);
+        if (baseline != 0) getVirtualMemoryStatistics(baseline, &baselineStats);
+        printDedupStatistics(stdout, &stats, baseline != 0 ? &baselineStats : 0);
+    }
+    if (running.numNodes > 1) {
+        VirtualMemoryStatistics baselineStats;
+        baselineStats.size = sizeof(baselineStats);
+        if (baseline != 0) getVirtualMemoryStatistics(baseline, &baselineStats);
+        printNodeStatistics(stdout, &stats, baseline != 0 ? &baselineStats : 0);
+    }
+    if (profile != 0) {
+        stopProfile(profile);
+        printProfile(stderr, profile);
+        freeProfile(profile);
+    }
+
+    // Free memory
+    freeVirtualMemory(vm);
+    if (baseline != 0) freeVirtualMemory(baseline);
+    free(line);
+
+    // Close files
+    fclose(addressesFile);
+
+    return 0;
+}
+
+
+/*********** Function Definitions ***********/
+
+static void usage(char *name) {
+    fprintf(stderr, "Usage: %s [options] <filepath>\n", name);
+    fprintf(stderr, "  --profile                  report where simulation time goes on stderr\n");
+    fprintf(stderr, "  --interval N               write statistics every N references\n");
+    fprintf(stderr, "  --quantum NS               write statistics every NS simulated nanoseconds\n");
+    fprintf(stderr, "  --interval-out PATH        interval output file (default intervals.csv)\n");
+    fprintf(stderr, "  --interval-format FORMAT   csv or binary\n");
+    fprintf(stderr, "  --checkpoint PATH          save simulator state here at exit or interrupt\n");
+    fprintf(stderr, "  --checkpoint-every N       also save it every N references\n");
+    fprintf(stderr, "  --restore PATH             resume from a checkpoint at its trace offset\n");
+    fprintf(stderr, "  --from-start               with --restore, replay the trace from the start\n");
+    fprintf(stderr, "  --sample RATE              estimate rates by simulating a RATE fraction of pages\n");
+    fprintf(stderr, "  --sample-seed N            hash seed choosing the sampled pages\n");
+    fprintf(stderr, "  --zswap BYTES              keep evicted pages in a compressed pool of BYTES\n");
+    fprintf(stderr, "  --dedup                    share frames between pages with identical contents\n");
+    fprintf(stderr, "  --nodes F:NS,F:NS,...      split memory into nodes of F frames and NS latency\n");
+    fprintf(stderr, "  --placement POLICY         first-touch, interleave or tiered (fastest node first)\n");
+    fprintf(stderr, "  --migrate-every N          with tiered, scan for hot pages every N references\n");
+    fprintf(stderr, "  --compact                  collapse same page runs, print statistics only\n");
+    fprintf(stderr, "  --expand                   with --compact, still print every access\n");
+    fprintf(stderr, "  --backing-store PATH       page contents (default %s)\n", VMM_BACKING_STORE);
+}
+
+static int parseOptions(int argc, char **argv, CLIOptions *options) {
+    static struct option longOptions[] = {
+        { "profile",         no_argument,       0, 'p' },
+        { "interval",        required_argument, 0, 'i' },
+        { "quantum",         required_argument, 0, 'q' },
+        { "interval-out",    required_argument, 0, 'o' },
+        { "interval-format", required_argument, 0, 'f' },
+        { "checkpoint",      required_argument, 0, 'c' },
+        { "checkpoint-every", required_argument, 0, 'e' },
+        { "restore",         required_argument, 0, 'r' },
+        { "from-start",      no_argument,       0, 's' },
+        { "sample",          required_argument, 0, 'S' },
+        { "sample-seed",     required_argument, 0, 'D' },
+        { "zswap",           required_argument, 0, 'z' },
+        { "dedup",           no_argument,       0, 'm' },
+        { "nodes",           required_argument, 0, 'n' },
+        { "placement",       required_argument, 0, 'P' },
+        { "migrate-every",   required_argument, 0, 'M' },
+        { "compact",         no_argument,       0, 'C' },
+        { "expand",          no_argument,       0, 'x' },
+        { "backing-store",   required_argument, 0, 'b' },
+        { 0, 0, 0, 0 }
+    };
+    memset(options, 0, sizeof(CLIOptions));
+    options->backingStorePath = VMM_BACKING_STORE;
+    options->intervalPath = "intervals.csv";
+    options->intervalFormat = CSV_INTERVALS;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", longOptions, 0)) != -1) {
+        switch (opt) {
+            case 'p':
+                options->profiling = 1;
+                break;
+            case 'i':
+                options->intervalReferences = strtoull(optarg, 0, 10);
+                break;
+            case 'q':
+                options->intervalQuantum = strtoull(optarg, 0, 10);
+                break;
+            case 'o':
+                options->intervalPath = optarg;
+                break;
+            case 'f':
+                if (!parseIntervalFormat(optarg, &options->intervalFormat)) return 0;
+                break;
+            case 'c':
+                options->checkpointPath = optarg;
+                break;
+            case 'e':
+                options->checkpointEvery = strtoull(optarg, 0, 10);
+                break;
+            case 'r':
+                options->restorePath = optarg;
+                break;
+            case 's':
+                options->fromStart = 1;
+                break;
+            case 'S':
+                options->sampleRate = atof(optarg);
+                if (options->sampleRate <= 0 || options->sampleRate > 1) return 0;
+                break;
+            case 'D':
+                options->sampleSeed = strtoull(optarg, 0, 10);
+                break;
+            case 'z':
+                options->compressedPoolBytes = strtoull(optarg, 0, 10);
+                if (options->compressedPoolBytes == 0) return 0;
+                break;
+            case 'm':
+                options->deduplicate = 1;
+                break;
+            case 'n':
+                if (!parseNodes(optarg, options)) return 0;
+                break;
+            case 'P':
+                if (!parsePlacementPolicy(optarg, &options->placement)) return 0;
+                break;
+            case 'M':
+                options->migrationPeriod = strtoull(optarg, 0, 10);
+                if (options->migrationPeriod == 0) return 0;
+                break;
+            case 'C':
+                options->compact = 1;
+                break;
+            case 'x':
+                options->expand = 1;
+                break;
+            case 'b':
+                options->backingStorePath = optarg;
+                break;
+            default:
+                return 0;
+        }
+    }
+    if (optind != argc - 1) return 0;
+    if (options->checkpointEvery > 0 && options->checkpointPath == 0) return 0;
+    // Sampled runs only produce estimates, so there is no state to save
+    if (options->sampleRate > 0 && (options->checkpointPath != 0 || options->restorePath != 0)) return 0;
+    // Shared frames would have to live on one node for all their sharers
+    if (options->deduplicate && options->numNodes > 1) return 0;
+    if (options->expand && !options->compact) return 0;
+    // A pending run has been read but not translated, so the trace offset
+    // would not match the saved state
+    if (options->compact && (options->checkpointPath != 0 || options->restorePath != 0 || options->sampleRate > 0)) return 0;
+    options->addressPath = argv[optind];
+    return 1;
+}
+
+static FILE *openFile(char *filename, char *mode) {
+    assert(filename != 0);
+    assert(strcmp(filename, "") != 0);
+    assert(mode != 0);
+    assert(strcmp(mode, "") != 0);
+    FILE *fp = fopen(filename, mode);
+    // check if file was opened
+    if (fp == 0) {
+        char *modeString;
+        // check for supported file mode
+        if (strcmp(mode, "r") == 0)         modeString = "reading";
+        else if (strcmp(mode, "rb") == 0)   modeString = "reading binary";
+        else                                modeString = "";
+        fprintf(stderr, "Error: Cannot open %s", filename);
+        // file mode not supported
+        if (strcmp(mode, "") != 0) fprintf(stderr, " for %s!", modeString);
+        printf("\n");
+        exit(1);
+    }
+    return fp;
+}
+
+static uint64_t parseAddress(char *line) {
+    // A trailing W marks a write access, anything else is a read
+    uint64_t address = (uint32_t)atoi(line);
+    if (strpbrk(line, "Ww") != 0) address |= VMM_WRITE_FLAG;
+    return address;
+}
+
+static int parseNodes(char *spec, CLIOptions *options) {
+    // FRAMES:LATENCY per node, comma separated
+    int total = 0;
+    options->numNodes = 0;
+    char *end = spec;
+    while (*end != '\0') {
+        if (options->numNodes == VMM_MAX_NODES) return 0;
+        long frames = strtol(end, &end, 10);
+        if (*end != ':' || frames <= 0) return 0;
+        uint64_t latency = strtoull(end + 1, &end, 10);
+        if (*end != ',' && *end != '\0') return 0;
+        if (*end == ',') end++;
+        options->nodeFrames[options->numNodes] = (int)frames;
+        options->nodeLatency[options->numNodes] = latency;
+        options->numNodes++;
+        total += (int)frames;
+        if (total > VMM_MAX_FRAMES) return 0;
+    }
+    return options->numNodes > 0;
+}
+
+static void printTranslations(FILE *fp, VirtualMemory *vm, Profile *profile, const uint64_t *virtualAddresses, size_t count) {
+    assert(vm != 0);
+    uint32_t physicalAddresses[BATCH_SIZE];
+    int values[BATCH_SIZE];
+    assert(count <= BATCH_SIZE);
+    translateBatch(vm, virtualAddresses, count, physicalAddresses, values);
+    PROFILE_MARK(profile, mark);
+    for (size_t i = 0; i < count; ++i) {
+        fprintf(fp, "Virtual address: %d Physical address: %d Value: %d\n", (int)(uint32_t)virtualAddresses[i], (int)physicalAddresses[i], values[i]);
+    }
+    PROFILE_SAMPLES(profile, OUTPUT_PHASE, mark, count);
+}
+
+static void handleInterrupt(int sig) {
+    (void)sig;
+    interrupted = 1;
+}
+
+static void saveCheckpoint(VirtualMemory *vm, char *path, FILE *addressesFile) {
+    // Every line read so far has been translated, so the file position is
+    // where a resumed run picks up
+    if (!saveVirtualMemory(vm, path, (uint64_t)ftell(addressesFile))) {
+        fprintf(stderr, "Error: Cannot write checkpoint %s!\n", path);
+    }
+}
+
+static int runSampledSimulator(CLIOptions *options, VirtualMemoryConfig *config, FILE *addressesFile) {
+    SampledSimulation *sim = newSampledSimulation(config, options->sampleRate, options->sampleSeed);
+    if (sim == 0) {
+        fprintf(stderr, "Error: Cannot sample at rate %g from %s!\n", options->sampleRate, config->backingStorePath);
+        exit(1);
+    }
+    uint64_t virtualAddresses[BATCH_SIZE];
+    size_t count = 0;
+    char *line = 0;
+    size_t len = 0;
+    while (getline(&line, &len, addressesFile) != -1) {
+        virtualAddresses[count++] = parseAddress(line);
+        if (count == BATCH_SIZE) {
+            sampleBatch(sim, virtualAddresses, count);
+            count = 0;
+        }
+    }
+    sampleBatch(sim, virtualAddresses, count);
+
+    SampledEstimate estimate;
+    getSampledEstimate(sim, &estimate);
+    printSampledEstimate(stdout, &estimate);
+
+    freeSampledSimulation(sim);
+    free(line);
+    fclose(addressesFile);
+    return 0;
+}
+
+
+/********** TraceRun Definitions **********/
+
+static void initTraceRun(TraceRun *run, int expand) {
+    assert(run != 0);
+    run->first = 0;
+    run->length = 0;
+    run->expand = expand;
+    run->addresses = expand ? malloc(sizeof(uint64_t) * BATCH_SIZE) : 0;
+}
+
+static void addTraceRunAddress(TraceRun *run, FILE *fp, VirtualMemory *vm, VirtualMemory *baseline, uint64_t address) {
+    assert(run != 0);
+    // Same page and the same access kind extends the run
+    uint64_t key = VMM_WRITE_FLAG | ((VMM_NUM_PAGES - 1) * VMM_PAGE_SIZE);
+    if (run->length > 0 && ((run->first ^ address) & key) != 0) flushTraceRun(run, fp, vm, baseline);
+    if (run->length == 0) run->first = address;
+    if (run->expand) {
+        // A long run goes out in batches, the next one picks up on the same page
+        if (run->length == BATCH_SIZE) flushTraceRun(run, fp, vm, baseline);
+        if (run->length == 0) run->first = address;
+        run->addresses[run->length] = address;
+    }
+    run->length++;
+}
+
+static void flushTraceRun(TraceRun *run, FILE *fp, VirtualMemory *vm, VirtualMemory *baseline) {
+    assert(run != 0);
+    // translateRun may stop short at a migration or interval boundary
+    for (size_t done = 0; done < run->length; ) {
+        uint32_t physicalAddress;
+        size_t n = translateRun(vm, run->first, run->length - done, &physicalAddress);
+        if (run->expand) {
+            // The frame cannot change inside what one call consumed
+            uint32_t frameBase = physicalAddress - physicalAddress % VMM_FRAME_SIZE;
+            for (size_t i = done; i < done + n; ++i) {
+                uint32_t address = frameBase + run->addresses[i] % VMM_PAGE_SIZE;
+                int value = 0;
+                getVirtualMemoryValue(vm, address, &value);
+                fprintf(fp, "Virtual address: %d Physical address: %d Value: %d\n", (int)(uint32_t)run->addresses[i], (int)address, value);
+            }
+        }
+        done += n;
+    }
+    for (size_t done = 0; baseline != 0 && done < run->length; ) {
+        done += translateRun(baseline, run->first, run->length - done, 0);
+    }
+    run->length = 0;
+}
+
+static void freeTraceRun(TraceRun *run) {
+    assert(run != 0);
+    free(run->addresses);
+}
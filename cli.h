@@ -0,0 +1,9 @@
+#ifndef CLI_H
+#define CLI_H
+
+#include "vmm.h"
+
+/* Function Prototypes */
+int runSimulator(int, char **, ReplacementPolicy, int);
+
+#endif
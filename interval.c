@@ -0,0 +1,184 @@
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "interval.h"
+
+
+/* Global Constants */
+#define BINARY_MAGIC        "VMMI"
+#define BINARY_VERSION      1
+#define IDLE_SLEEP_NS       1000000
+
+/* Function Prototypes */
+static void *runIntervalWriter(void *);
+static void writeIntervalHeader(IntervalSampler *);
+static void writeIntervalRecord(IntervalSampler *, const VirtualMemoryStatistics *);
+
+
+/********** IntervalSampler Definitions **********/
+
+// Single producer, single consumer ring: the simulation thread only ever
+// advances head and the writer thread only ever advances tail, so neither
+// takes a lock. A full ring drops the sample instead of blocking.
+typedef struct IntervalSampler {
+    FILE *fp;
+    IntervalFormat format;
+    uint64_t references;
+    uint64_t quantum;
+    size_t capacity;
+    VirtualMemoryStatistics *ring;
+    uint64_t head;
+    uint64_t tail;
+    uint64_t dropped;
+    int stopping;
+    pthread_t writer;
+    int primed;
+    uint64_t written;
+    VirtualMemoryStatistics last;
+} IntervalSampler;
+
+IntervalSampler *newIntervalSampler(FILE *fp, IntervalFormat format, uint64_t references, uint64_t quantum, size_t capacity) {
+    assert(fp != 0);
+    assert(references > 0 || quantum > 0);
+    assert(capacity > 0);
+    IntervalSampler *sampler = calloc(1, sizeof(IntervalSampler));
+    sampler->fp = fp;
+    sampler->format = format;
+    sampler->references = references;
+    sampler->quantum = quantum;
+    sampler->capacity = capacity;
+    sampler->ring = malloc(sizeof(VirtualMemoryStatistics) * capacity);
+    writeIntervalHeader(sampler);
+    if (pthread_create(&sampler->writer, 0, runIntervalWriter, sampler) != 0) {
+        free(sampler->ring);
+        free(sampler);
+        return 0;
+    }
+    return sampler;
+}
+
+uint64_t getIntervalSamplerReferences(IntervalSampler *sampler) {
+    assert(sampler != 0);
+    return sampler->references;
+}
+
+uint64_t getIntervalSamplerQuantum(IntervalSampler *sampler) {
+    assert(sampler != 0);
+    return sampler->quantum;
+}
+
+int pushIntervalSample(IntervalSampler *sampler, const VirtualMemoryStatistics *stats) {
+    assert(sampler != 0);
+    assert(stats != 0);
+    uint64_t head = sampler->head;
+    uint64_t tail = __atomic_load_n(&sampler->tail, __ATOMIC_ACQUIRE);
+    if (head - tail == sampler->capacity) {
+        sampler->dropped++;
+        return 0;
+    }
+    // Fields a shorter caller layout lacks read as zero
+    VirtualMemoryStatistics *slot = &sampler->ring[head % sampler->capacity];
+    memset(slot, 0, sizeof(VirtualMemoryStatistics));
+    memcpy(slot, stats, stats->size < sizeof(VirtualMemoryStatistics) ? stats->size : sizeof(VirtualMemoryStatistics));
+    __atomic_store_n(&sampler->head, head + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+uint64_t getIntervalSamplerDropped(IntervalSampler *sampler) {
+    assert(sampler != 0);
+    return sampler->dropped;
+}
+
+void freeIntervalSampler(IntervalSampler *sampler) {
+    assert(sampler != 0);
+    // The writer drains whatever is still queued before it exits
+    __atomic_store_n(&sampler->stopping, 1, __ATOMIC_RELEASE);
+    pthread_join(sampler->writer, 0);
+    fflush(sampler->fp);
+    free(sampler->ring);
+    free(sampler);
+}
+
+
+/*********** Function Definitions ***********/
+
+int parseIntervalFormat(const char *name, IntervalFormat *format) {
+    assert(name != 0);
+    assert(format != 0);
+    if (strcmp(name, "csv") == 0)           *format = CSV_INTERVALS;
+    else if (strcmp(name, "binary") == 0)   *format = BINARY_INTERVALS;
+    else                                    return 0;
+    return 1;
+}
+
+static void *runIntervalWriter(void *arg) {
+    IntervalSampler *sampler = arg;
+    for (;;) {
+        int stopping = __atomic_load_n(&sampler->stopping, __ATOMIC_ACQUIRE);
+        uint64_t head = __atomic_load_n(&sampler->head, __ATOMIC_ACQUIRE);
+        uint64_t tail = sampler->tail;
+        if (tail == head) {
+            if (stopping) break;
+            struct timespec idle = { 0, IDLE_SLEEP_NS };
+            nanosleep(&idle, 0);
+            continue;
+        }
+        for (; tail != head; ++tail) {
+            writeIntervalRecord(sampler, &sampler->ring[tail % sampler->capacity]);
+        }
+        __atomic_store_n(&sampler->tail, tail, __ATOMIC_RELEASE);
+    }
+    return 0;
+}
+
+static void writeIntervalHeader(IntervalSampler *sampler) {
+    if (sampler->format == BINARY_INTERVALS) {
+        uint32_t version = BINARY_VERSION;
+        fwrite(BINARY_MAGIC, 1, 4, sampler->fp);
+        fwrite(&version, sizeof(version), 1, sampler->fp);
+    }
+    else {
+        fprintf(sampler->fp, "interval,end_reference,end_time_ns,references,page_faults,fault_rate,"
+                "tlb_hits,tlb_hit_rate,resident_pages,evictions,write_backs\n");
+    }
+}
+
+static void writeIntervalRecord(IntervalSampler *sampler, const VirtualMemoryStatistics *stats) {
+    VirtualMemoryStatistics *last = &sampler->last;
+    if (!sampler->primed) {
+        // The first sample is the baseline the intervals are measured from
+        *last = *stats;
+        sampler->primed = 1;
+        return;
+    }
+    if (stats->numTranslated == last->numTranslated && stats->simulatedTime == last->simulatedTime) return;
+    IntervalRecord record;
+    record.index = sampler->written++;
+    record.endReference = stats->numTranslated;
+    record.endTime = stats->simulatedTime;
+    record.references = stats->numTranslated - last->numTranslated;
+    record.pageFaults = stats->numPageFaults - last->numPageFaults;
+    record.TLBhits = stats->numTLBhits - last->numTLBhits;
+    record.evictions = stats->numEvictions - last->numEvictions;
+    record.writeBacks = stats->numWriteBacks - last->numWriteBacks;
+    record.residentPages = stats->residentPages;
+    *last = *stats;
+    if (sampler->format == BINARY_INTERVALS) {
+        fwrite(&record, sizeof(record), 1, sampler->fp);
+        return;
+    }
+    double references = record.references ? record.references : 1;
+    fprintf(sampler->fp, "%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%.6f,%" PRIu64 ",%.6f,%" PRIu64 ",%" PRIu64 ",%" PRIu64 "\n",
+            record.index, record.endReference, record.endTime, record.references,
+            record.pageFaults, record.pageFaults / references,
+            record.TLBhits, record.TLBhits / references,
+            record.residentPages, record.evictions, record.writeBacks);
+}
@@ -0,0 +1,49 @@
+#ifndef INTERVAL_H
+#define INTERVAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "vmm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Output Formats */
+typedef enum IntervalFormat {
+    CSV_INTERVALS,
+    BINARY_INTERVALS
+} IntervalFormat;
+
+/* One interval as written by the binary format after the "VMMI" magic
+   and a uint32_t version, in host byte order */
+typedef struct IntervalRecord {
+    uint64_t index;
+    uint64_t endReference;
+    uint64_t endTime;
+    uint64_t references;
+    uint64_t pageFaults;
+    uint64_t TLBhits;
+    uint64_t evictions;
+    uint64_t writeBacks;
+    uint64_t residentPages;
+} IntervalRecord;
+
+/* IntervalSampler Function Prototypes */
+IntervalSampler *newIntervalSampler(FILE *, IntervalFormat, uint64_t, uint64_t, size_t);
+uint64_t getIntervalSamplerReferences(IntervalSampler *);
+uint64_t getIntervalSamplerQuantum(IntervalSampler *);
+int pushIntervalSample(IntervalSampler *, const VirtualMemoryStatistics *);
+uint64_t getIntervalSamplerDropped(IntervalSampler *);
+void freeIntervalSampler(IntervalSampler *);
+
+/* Function Prototypes */
+int parseIntervalFormat(const char *, IntervalFormat *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
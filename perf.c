@@ -0,0 +1,99 @@
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#include "perf.h"
+
+
+/********** PerfCounters Definitions **********/
+
+typedef struct PerfCounters {
+    int fds[NUM_PERF_EVENTS];
+} PerfCounters;
+
+#ifdef __linux__
+static int openPerfEvent(uint32_t type, uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+PerfCounters *newPerfCounters(void) {
+    PerfCounters *pc = malloc(sizeof(PerfCounters));
+    for (int i = 0; i < NUM_PERF_EVENTS; ++i) {
+        pc->fds[i] = -1;
+    }
+#ifdef __linux__
+    // Events the host or container does not expose stay closed
+    pc->fds[PERF_CYCLES] = openPerfEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    pc->fds[PERF_CACHE_MISSES] = openPerfEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    pc->fds[PERF_DTLB_MISSES] = openPerfEvent(PERF_TYPE_HW_CACHE,
+            PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    for (int i = 0; i < NUM_PERF_EVENTS; ++i) {
+        if (pc->fds[i] != -1) ioctl(pc->fds[i], PERF_EVENT_IOC_RESET, 0);
+    }
+#endif
+    return pc;
+}
+
+void startPerfCounters(PerfCounters *pc) {
+    assert(pc != 0);
+#ifdef __linux__
+    for (int i = 0; i < NUM_PERF_EVENTS; ++i) {
+        if (pc->fds[i] != -1) ioctl(pc->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+void stopPerfCounters(PerfCounters *pc) {
+    assert(pc != 0);
+#ifdef __linux__
+    for (int i = 0; i < NUM_PERF_EVENTS; ++i) {
+        if (pc->fds[i] != -1) ioctl(pc->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+    }
+#endif
+}
+
+int readPerfCounter(PerfCounters *pc, PerfEvent event, uint64_t *value) {
+    assert(pc != 0);
+    assert(value != 0);
+    if (pc->fds[event] == -1) return 0;
+    return read(pc->fds[event], value, sizeof(uint64_t)) == sizeof(uint64_t);
+}
+
+void freePerfCounters(PerfCounters *pc) {
+    assert(pc != 0);
+    for (int i = 0; i < NUM_PERF_EVENTS; ++i) {
+        if (pc->fds[i] != -1) close(pc->fds[i]);
+    }
+    free(pc);
+}
+
+
+/*********** Function Definitions ***********/
+
+const char *getPerfEventName(PerfEvent event) {
+    switch (event) {
+        case PERF_CYCLES:       return "cycles";
+        case PERF_CACHE_MISSES: return "cache_misses";
+        case PERF_DTLB_MISSES:  return "dtlb_misses";
+        default:                return "unknown";
+    }
+}
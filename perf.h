@@ -0,0 +1,27 @@
+#ifndef PERF_H
+#define PERF_H
+
+#include <stdint.h>
+
+/* Hardware Events */
+typedef enum PerfEvent {
+    PERF_CYCLES,
+    PERF_CACHE_MISSES,
+    PERF_DTLB_MISSES,
+    NUM_PERF_EVENTS
+} PerfEvent;
+
+/* Struct Type Prototypes */
+typedef struct PerfCounters PerfCounters;
+
+/* PerfCounters Function Prototypes */
+PerfCounters *newPerfCounters(void);
+void startPerfCounters(PerfCounters *);
+void stopPerfCounters(PerfCounters *);
+int readPerfCounter(PerfCounters *, PerfEvent, uint64_t *);
+void freePerfCounters(PerfCounters *);
+
+/* Function Prototypes */
+const char *getPerfEventName(PerfEvent);
+
+#endif
@@ -0,0 +1,159 @@
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "perf.h"
+#include "profile.h"
+
+
+/* Global Constants */
+#define SUB_BUCKET_BITS     4
+#define SUB_BUCKETS         (1 << SUB_BUCKET_BITS)
+#define NUM_BUCKETS         (64 * SUB_BUCKETS)
+
+/* Function Prototypes */
+static uint64_t readNanoseconds(void);
+static int getHistogramIndex(uint64_t);
+static uint64_t getHistogramValue(int);
+static uint64_t getHistogramPercentile(Profile *, double);
+
+
+/********** Profile Definitions **********/
+
+typedef struct Profile {
+    uint64_t ticks[NUM_PROFILE_PHASES];
+    uint64_t calls[NUM_PROFILE_PHASES];
+    uint64_t histogram[NUM_BUCKETS];
+    uint64_t numFaults;
+    uint64_t maxFaultTicks;
+    uint64_t startClock;
+    uint64_t startNanoseconds;
+    uint64_t stopClock;
+    uint64_t stopNanoseconds;
+    PerfCounters *counters;
+} Profile;
+
+Profile *newProfile(int withCounters) {
+    Profile *profile = calloc(1, sizeof(Profile));
+    if (withCounters) {
+        profile->counters = newPerfCounters();
+        startPerfCounters(profile->counters);
+    }
+    profile->startNanoseconds = readNanoseconds();
+    profile->startClock = readProfileClock();
+    return profile;
+}
+
+void addProfileSample(Profile *profile, ProfilePhase phase, uint64_t ticks, uint64_t calls) {
+    assert(profile != 0);
+    profile->ticks[phase] += ticks;
+    profile->calls[phase] += calls;
+}
+
+void addFaultLatency(Profile *profile, uint64_t ticks) {
+    assert(profile != 0);
+    profile->histogram[getHistogramIndex(ticks)]++;
+    profile->numFaults++;
+    if (ticks > profile->maxFaultTicks) profile->maxFaultTicks = ticks;
+}
+
+void stopProfile(Profile *profile) {
+    assert(profile != 0);
+    profile->stopClock = readProfileClock();
+    profile->stopNanoseconds = readNanoseconds();
+    if (profile->counters != 0) stopPerfCounters(profile->counters);
+}
+
+void printProfile(FILE *fp, Profile *profile) {
+    assert(profile != 0);
+    static const char *phaseNames[NUM_PROFILE_PHASES] = {
+        "parse", "tlb", "page_table", "fault", "output"
+    };
+    if (profile->stopClock == 0) stopProfile(profile);
+    uint64_t elapsedClock = profile->stopClock - profile->startClock;
+    uint64_t elapsedNanoseconds = profile->stopNanoseconds - profile->startNanoseconds;
+    double nsPerTick = elapsedClock ? (double)elapsedNanoseconds / elapsedClock : 1.0;
+    uint64_t accounted = 0;
+    for (int i = 0; i < NUM_PROFILE_PHASES; ++i) {
+        accounted += profile->ticks[i];
+    }
+
+    fprintf(fp, "Profile: %.3f ms wall, %.3f ns per clock tick\n", elapsedNanoseconds / 1e6, nsPerTick);
+    fprintf(fp, "(tlb and page_table timed on 1 in %d references and scaled)\n", PROFILE_SAMPLE_PERIOD);
+    fprintf(fp, "%-12s %12s %12s %8s %10s\n", "Phase", "Calls", "Total ms", "Share", "ns/call");
+    for (int i = 0; i < NUM_PROFILE_PHASES; ++i) {
+        double ms = profile->ticks[i] * nsPerTick / 1e6;
+        double share = accounted ? 100.0 * profile->ticks[i] / accounted : 0;
+        double perCall = profile->calls[i] ? profile->ticks[i] * nsPerTick / profile->calls[i] : 0;
+        fprintf(fp, "%-12s %12" PRIu64 " %12.3f %7.1f%% %10.1f\n", phaseNames[i], profile->calls[i], ms, share, perCall);
+    }
+    if (profile->numFaults > 0) {
+        fprintf(fp, "Fault latency ns: p50 = %.0f p90 = %.0f p99 = %.0f p99.9 = %.0f max = %.0f\n",
+                getHistogramPercentile(profile, 0.50) * nsPerTick,
+                getHistogramPercentile(profile, 0.90) * nsPerTick,
+                getHistogramPercentile(profile, 0.99) * nsPerTick,
+                getHistogramPercentile(profile, 0.999) * nsPerTick,
+                profile->maxFaultTicks * nsPerTick);
+    }
+    if (profile->counters != 0) {
+        fprintf(fp, "Hardware counters:");
+        for (int i = 0; i < NUM_PERF_EVENTS; ++i) {
+            uint64_t value;
+            if (readPerfCounter(profile->counters, i, &value)) fprintf(fp, " %s = %" PRIu64, getPerfEventName(i), value);
+            else                                               fprintf(fp, " %s = n/a", getPerfEventName(i));
+        }
+        fprintf(fp, "\n");
+    }
+}
+
+void freeProfile(Profile *profile) {
+    assert(profile != 0);
+    if (profile->counters != 0) freePerfCounters(profile->counters);
+    free(profile);
+}
+
+
+/*********** Function Definitions ***********/
+
+static uint64_t readNanoseconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int getHistogramIndex(uint64_t value) {
+    // Log-linear buckets: SUB_BUCKETS linear steps per power of two
+    if (value < SUB_BUCKETS) return (int)value;
+    int magnitude = 63 - __builtin_clzll(value);
+    int bucket = magnitude - SUB_BUCKET_BITS + 1;
+    int sub = (int)((value >> (bucket - 1)) - SUB_BUCKETS);
+    return bucket * SUB_BUCKETS + sub;
+}
+
+static uint64_t getHistogramValue(int index) {
+    // Highest value that lands in the bucket
+    int bucket = index / SUB_BUCKETS;
+    int sub = index % SUB_BUCKETS;
+    if (bucket == 0) return sub;
+    return ((uint64_t)(SUB_BUCKETS + sub + 1) << (bucket - 1)) - 1;
+}
+
+static uint64_t getHistogramPercentile(Profile *profile, double percentile) {
+    uint64_t target = (uint64_t)(percentile * profile->numFaults);
+    if (target >= profile->numFaults) target = profile->numFaults - 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < NUM_BUCKETS; ++i) {
+        seen += profile->histogram[i];
+        if (seen > target) {
+            uint64_t value = getHistogramValue(i);
+            return value < profile->maxFaultTicks ? value : profile->maxFaultTicks;
+        }
+    }
+    return profile->maxFaultTicks;
+}
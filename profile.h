@@ -0,0 +1,94 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Profiled Phases */
+typedef enum ProfilePhase {
+    PARSE_PHASE,
+    TLB_PHASE,
+    PAGE_TABLE_PHASE,
+    FAULT_PHASE,
+    OUTPUT_PHASE,
+    NUM_PROFILE_PHASES
+} ProfilePhase;
+
+/* Struct Type Prototypes */
+typedef struct Profile Profile;
+
+/* Profile Function Prototypes */
+Profile *newProfile(int);
+void addProfileSample(Profile *, ProfilePhase, uint64_t, uint64_t);
+void addFaultLatency(Profile *, uint64_t);
+void stopProfile(Profile *);
+void printProfile(FILE *, Profile *);
+void freeProfile(Profile *);
+
+/* Profile Clock: TSC ticks on x86, nanoseconds elsewhere */
+static inline uint64_t readProfileClock(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+/* Hot path hooks, compiled out unless VMM_PROFILE is defined. Per-reference
+   phases are timed on one reference in PROFILE_SAMPLE_PERIOD and scaled up. */
+#define PROFILE_SAMPLE_PERIOD               8
+#ifdef VMM_PROFILE
+#define PROFILE_MARK(profile, mark)         uint64_t mark = (profile) ? readProfileClock() : 0
+#define PROFILE_RESET(profile, mark)        mark = (profile) ? readProfileClock() : 0
+#define PROFILE_SAMPLED(profile, counter) \
+    (((counter) % PROFILE_SAMPLE_PERIOD) == 0 ? (profile) : 0)
+#define PROFILE_SAMPLES(profile, phase, mark, calls) \
+    do { \
+        if (profile) { \
+            uint64_t now__ = readProfileClock(); \
+            addProfileSample(profile, phase, now__ - mark, calls); \
+            mark = now__; \
+        } \
+    } while (0)
+#define PROFILE_SCALED(profile, phase, mark) \
+    do { \
+        if (profile) { \
+            uint64_t now__ = readProfileClock(); \
+            addProfileSample(profile, phase, (now__ - mark) * PROFILE_SAMPLE_PERIOD, PROFILE_SAMPLE_PERIOD); \
+            mark = now__; \
+        } \
+    } while (0)
+#define PROFILE_FAULT(profile, mark, outer) \
+    do { \
+        if (profile) { \
+            uint64_t now__ = readProfileClock(); \
+            addProfileSample(profile, FAULT_PHASE, now__ - mark, 1); \
+            addFaultLatency(profile, now__ - mark); \
+            outer += now__ - mark; \
+        } \
+    } while (0)
+#else
+#define PROFILE_MARK(profile, mark)         do { (void)(profile); } while (0)
+#define PROFILE_RESET(profile, mark)        do { (void)(profile); } while (0)
+#define PROFILE_SAMPLED(profile, counter)   ((void)(counter), (profile))
+#define PROFILE_SAMPLES(profile, phase, mark, calls) do { (void)(profile); } while (0)
+#define PROFILE_SCALED(profile, phase, mark) do { (void)(profile); } while (0)
+#define PROFILE_FAULT(profile, mark, outer) do { (void)(profile); } while (0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
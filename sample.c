@@ -0,0 +1,188 @@
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sample.h"
+
+
+/* Global Constants */
+#define NUM_PAGES           VMM_NUM_PAGES
+#define Z_95                1.96
+
+/* Function Prototypes */
+static uint64_t hashPageNumber(uint64_t, uint64_t);
+static int scaleBySampleRate(int, double);
+static double getRatioError(SampledSimulation *, uint64_t *, double);
+static double clampRate(double);
+
+
+/********** SampledSimulation Definitions **********/
+
+// SHARDS-style spatial sampling: a page is simulated iff its hash falls
+// under the rate threshold, so every reference to a sampled page is kept
+// and the cache sizes shrink by the same fraction of the page space.
+typedef struct SampledSimulation {
+    VirtualMemory *vm;
+    double rate;
+    int sampledPages;
+    int numFrames;
+    int TLBSize;
+    uint8_t isSampled[NUM_PAGES];
+    uint64_t references;
+    uint64_t pageReferences[NUM_PAGES];
+    uint64_t pageFaults[NUM_PAGES];
+    uint64_t pageTLBhits[NUM_PAGES];
+} SampledSimulation;
+
+SampledSimulation *newSampledSimulation(const VirtualMemoryConfig *config, double rate, uint64_t seed) {
+    assert(config != 0);
+    if (rate <= 0 || rate > 1) return 0;
+    if (config->size < VMM_CONFIG_MIN_SIZE || config->size > sizeof(VirtualMemoryConfig)) return 0;
+    SampledSimulation *sim = calloc(1, sizeof(SampledSimulation));
+    uint64_t threshold = rate >= 1 ? UINT64_MAX : (uint64_t)(rate * 18446744073709551616.0);
+    for (int i = 0; i < NUM_PAGES; ++i) {
+        sim->isSampled[i] = hashPageNumber(i, seed) <= threshold;
+        sim->sampledPages += sim->isSampled[i];
+    }
+    if (sim->sampledPages == 0) {
+        free(sim);
+        return 0;
+    }
+    // Scale by the fraction actually drawn rather than the nominal rate
+    sim->rate = (double)sim->sampledPages / NUM_PAGES;
+    VirtualMemoryConfig scaled;
+    scaled.size = sizeof(scaled);
+    initVirtualMemoryConfig(&scaled, config->policy);
+    memcpy(&scaled, config, config->size);
+    scaled.size = sizeof(scaled);
+    scaled.numFrames = scaleBySampleRate(config->numFrames, sim->rate);
+    scaled.TLBSize = scaleBySampleRate(config->TLBSize, sim->rate);
+    scaled.compressedPoolBytes = (size_t)(config->compressedPoolBytes * sim->rate);
+    if (config->numNodes > 1) {
+        scaled.numFrames = 0;
+        for (int i = 0; i < config->numNodes; ++i) {
+            scaled.nodeFrames[i] = scaleBySampleRate(config->nodeFrames[i], sim->rate);
+            scaled.numFrames += scaled.nodeFrames[i];
+        }
+    }
+    sim->numFrames = scaled.numFrames;
+    sim->TLBSize = scaled.TLBSize;
+    sim->vm = newVirtualMemory(&scaled);
+    if (sim->vm == 0) {
+        free(sim);
+        return 0;
+    }
+    return sim;
+}
+
+void sampleBatch(SampledSimulation *sim, const uint64_t *vaddrs, size_t n) {
+    assert(sim != 0);
+    assert(vaddrs != 0 || n == 0);
+    for (size_t i = 0; i < n; ++i) {
+        uint8_t pageNumber = (vaddrs[i] & 0xFFFF) >> 8;
+        if (!sim->isSampled[pageNumber]) continue;
+        int outcome = translateAddress(sim->vm, vaddrs[i], 0, 0);
+        sim->pageReferences[pageNumber]++;
+        if (outcome & VMM_PAGE_FAULT) sim->pageFaults[pageNumber]++;
+        if (outcome & VMM_TLB_HIT) sim->pageTLBhits[pageNumber]++;
+    }
+    sim->references += n;
+}
+
+void getSampledEstimate(SampledSimulation *sim, SampledEstimate *estimate) {
+    assert(sim != 0);
+    assert(estimate != 0);
+    VirtualMemoryStatistics stats;
+    stats.size = sizeof(stats);
+    getVirtualMemoryStatistics(sim->vm, &stats);
+    estimate->rate = sim->rate;
+    estimate->sampledPages = sim->sampledPages;
+    estimate->numFrames = sim->numFrames;
+    estimate->TLBSize = sim->TLBSize;
+    estimate->references = sim->references;
+    estimate->sampledReferences = stats.numTranslated;
+    double references = stats.numTranslated ? stats.numTranslated : 1;
+    estimate->faultRate = stats.numPageFaults / references;
+    estimate->TLBHitRate = stats.numTLBhits / references;
+    estimate->faultRateError = getRatioError(sim, sim->pageFaults, estimate->faultRate);
+    estimate->TLBHitRateError = getRatioError(sim, sim->pageTLBhits, estimate->TLBHitRate);
+    estimate->faultRateLow = clampRate(estimate->faultRate - estimate->faultRateError);
+    estimate->faultRateHigh = clampRate(estimate->faultRate + estimate->faultRateError);
+    estimate->TLBHitRateLow = clampRate(estimate->TLBHitRate - estimate->TLBHitRateError);
+    estimate->TLBHitRateHigh = clampRate(estimate->TLBHitRate + estimate->TLBHitRateError);
+    estimate->workingSet = 0;
+    for (int i = 0; i < NUM_PAGES; ++i) estimate->workingSet += sim->pageReferences[i] > 0;
+    // When the scaled frames land within the sampling noise of the sampled
+    // working set, whether the sample thrashes turns on which pages the hash
+    // drew and how the frame count rounded, and no bound covers that
+    double margin = Z_95 * sqrt(estimate->workingSet * (1.0 - sim->rate));
+    estimate->isInsufficient = abs(sim->numFrames - estimate->workingSet) <= margin;
+}
+
+void freeSampledSimulation(SampledSimulation *sim) {
+    assert(sim != 0);
+    freeVirtualMemory(sim->vm);
+    free(sim);
+}
+
+
+/*********** Function Definitions ***********/
+
+void printSampledEstimate(FILE *fp, const SampledEstimate *estimate) {
+    assert(estimate != 0);
+    fprintf(fp, "Sampled Pages = %d of %d (rate %.3f)\n", estimate->sampledPages, NUM_PAGES, estimate->rate);
+    fprintf(fp, "Scaled Frames = %d, Scaled TLB Size = %d\n", estimate->numFrames, estimate->TLBSize);
+    fprintf(fp, "Number of Translated Addresses = %llu (%llu simulated)\n",
+            (unsigned long long)estimate->references, (unsigned long long)estimate->sampledReferences);
+    fprintf(fp, "Sampled Working Set = %d pages\n", estimate->workingSet);
+    if (estimate->isInsufficient) {
+        fprintf(fp, "Estimated Page Fault Rate = %.3f (insufficient sample)\n", estimate->faultRate);
+        fprintf(fp, "Estimated TLB Hit Rate = %.3f (insufficient sample)\n", estimate->TLBHitRate);
+        return;
+    }
+    fprintf(fp, "Estimated Page Fault Rate = %.3f (%.3f to %.3f)\n",
+            estimate->faultRate, estimate->faultRateLow, estimate->faultRateHigh);
+    fprintf(fp, "Estimated TLB Hit Rate = %.3f (%.3f to %.3f)\n",
+            estimate->TLBHitRate, estimate->TLBHitRateLow, estimate->TLBHitRateHigh);
+}
+
+static uint64_t hashPageNumber(uint64_t page, uint64_t seed) {
+    // splitmix64 finalizer
+    uint64_t z = page + seed + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static int scaleBySampleRate(int size, double rate) {
+    int scaled = (int)(size * rate + 0.5);
+    return scaled < 1 ? 1 : scaled;
+}
+
+static double getRatioError(SampledSimulation *sim, uint64_t *pageEvents, double ratio) {
+    // Pages are the sampling clusters, so the error of events / references
+    // follows the ratio estimator over per-page totals, with a finite
+    // population correction for the 256 page space
+    int n = 0;
+    double references = 0;
+    double residuals = 0;
+    for (int i = 0; i < NUM_PAGES; ++i) {
+        if (!sim->isSampled[i] || sim->pageReferences[i] == 0) continue;
+        double r = pageEvents[i] - ratio * sim->pageReferences[i];
+        residuals += r * r;
+        references += sim->pageReferences[i];
+        n++;
+    }
+    if (n < 2) return 1.0;
+    double meanReferences = references / n;
+    double fpc = 1.0 - sim->rate;
+    double variance = fpc * residuals / ((double)n * (n - 1)) / (meanReferences * meanReferences);
+    return Z_95 * sqrt(variance);
+}
+
+static double clampRate(double rate) {
+    return rate < 0 ? 0 : rate > 1 ? 1 : rate;
+}
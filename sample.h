@@ -0,0 +1,48 @@
+#ifndef SAMPLE_H
+#define SAMPLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "vmm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Struct Type Prototypes */
+typedef struct SampledSimulation SampledSimulation;
+
+typedef struct SampledEstimate {
+    double rate;                // fraction of the page space simulated
+    int sampledPages;
+    int numFrames;              // frames after scaling by rate
+    int TLBSize;                // TLB entries after scaling by rate
+    uint64_t references;        // every reference offered to the sampler
+    uint64_t sampledReferences; // references that were simulated
+    int workingSet;             // sampled pages that were referenced
+    int isInsufficient;         // scaled frames too close to the working set to trust
+    double faultRate;
+    double faultRateError;      // 95% confidence half-width
+    double faultRateLow;        // the half-width clamped to [0, 1]
+    double faultRateHigh;
+    double TLBHitRate;
+    double TLBHitRateError;
+    double TLBHitRateLow;
+    double TLBHitRateHigh;
+} SampledEstimate;
+
+/* SampledSimulation Function Prototypes */
+SampledSimulation *newSampledSimulation(const VirtualMemoryConfig *, double, uint64_t);
+void sampleBatch(SampledSimulation *, const uint64_t *, size_t);
+void getSampledEstimate(SampledSimulation *, SampledEstimate *);
+void freeSampledSimulation(SampledSimulation *);
+
+/* Function Prototypes */
+void printSampledEstimate(FILE *, const SampledEstimate *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,1695 @@
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "interval.h"
+#include "vmm.h"
+#include "zswap.h"
+
+
+/* Global Constants */
+#define PAGE_MASK           0xFFFF
+#define OFFSET_MASK         0xFF
+#define PAGE_SIZE           VMM_PAGE_SIZE
+#define NUM_PAGES           VMM_NUM_PAGES
+#define FRAME_SIZE          VMM_FRAME_SIZE
+#define NO_FRAME            -1
+#define ANY_NODE            -1
+#define CHECKPOINT_MAGIC    "VMMCKPT"
+#define CHECKPOINT_VERSION  5
+#define CHECKPOINT_ALIGN    4096
+
+/* Struct Type Prototypes */
+typedef struct LogicalAddress LogicalAddress;
+typedef struct Page Page;
+typedef struct PageTable PageTable;
+typedef struct PhysicalMemory PhysicalMemory;
+typedef struct TLBNode TLBNode;
+typedef struct TLB TLB;
+typedef struct CheckpointHeader CheckpointHeader;
+typedef struct CheckpointPage CheckpointPage;
+typedef struct CheckpointTLBNode CheckpointTLBNode;
+typedef struct CheckpointFrame CheckpointFrame;
+
+/* LogicalAddress Function Prototypes */
+static void initLogicalAddress(LogicalAddress *, uint64_t);
+static int isLogicalAddressWrite(LogicalAddress *);
+static uint8_t getLogicalAddressPageNumber(LogicalAddress *);
+static uint8_t getLogicalAddressOffset(LogicalAddress *);
+
+/* Page Function Prototypes */
+static Page *newPage(uint8_t);
+static int isPageValid(Page *);
+static void setPageValidation(Page *, int);
+static int isPageDirty(Page *);
+static void setPageDirty(Page *, int);
+static uint8_t getPageFrameNumber(Page *);
+static void setPageFrameNumber(Page *, uint8_t);
+static uint64_t getPageLastUsed(Page *);
+static void setPageLastUsed(Page *, uint64_t);
+static uint32_t getPageAccessCount(Page *);
+static void setPageAccessCount(Page *, uint32_t);
+
+/* PageTable Function Prototypes */
+static PageTable *newPageTable(void);
+static Page *getPageFromPageTable(PageTable *, int);
+static void freePageTable(PageTable *);
+
+/* PhysicalMemory Function Prototypes */
+static PhysicalMemory *newPhysicalMemory(int);
+static char *getPhysicalMemoryAtIndex(PhysicalMemory *, int);
+static int getPhysicalMemoryValue(PhysicalMemory *, int, int);
+static int getPhysicalMemoryFramePage(PhysicalMemory *, int);
+static void setPhysicalMemoryFramePage(PhysicalMemory *, int, int);
+static int getPhysicalMemoryFrameRefs(PhysicalMemory *, int);
+static void setPhysicalMemoryFrameRefs(PhysicalMemory *, int, int);
+static int findIdenticalFrame(PhysicalMemory *, const char *, uint64_t);
+static void freePhysicalMemory(PhysicalMemory *);
+
+/* TLBNode Function Prototypes */
+static TLBNode *newTLBNode(void);
+static int isTLBNodeValid(TLBNode *);
+static void setTLBNode(TLBNode *, uint8_t, uint8_t);
+static void invalidateTLBNode(TLBNode *);
+
+/* TLB Function Prototypes */
+static TLB *newTLB(int);
+static int TLBlookup(TLB *, uint8_t);
+static void updateTLB(TLB *, uint8_t, uint8_t);
+static void invalidateTLBPage(TLB *, uint8_t);
+static void freeTLB(TLB *);
+
+/* Function Prototypes */
+static uint32_t translateLogicalToPhysicalAddress(uint8_t, LogicalAddress *);
+static uint8_t resolveFrame(VirtualMemory *, LogicalAddress *, int *);
+static int selectVictimFrame(VirtualMemory *);
+static int getLRUindex(PageTable *);
+static uint64_t handlePageFault(VirtualMemory *, uint8_t);
+static uint64_t handleMergingPageFault(VirtualMemory *, uint8_t);
+static uint64_t allocateFrame(VirtualMemory *, int *);
+static int selectSharedVictimFrame(VirtualMemory *);
+static uint64_t copyOnWrite(VirtualMemory *, uint8_t);
+static uint64_t loadPage(VirtualMemory *, uint8_t, char *, int *);
+static void mapPage(VirtualMemory *, int, int, int);
+static uint64_t evictPage(VirtualMemory *, int);
+static void unmapPage(VirtualMemory *, int);
+static int compressVictim(VirtualMemory *, int, int, int, uint64_t *);
+static uint64_t hashFrame(const char *);
+static int getFrameNode(VirtualMemory *, int);
+static int findFreeFrame(VirtualMemory *, int);
+static uint64_t handleNodePageFault(VirtualMemory *, uint8_t);
+static int selectPlacementNode(VirtualMemory *);
+static int selectNodeVictimFrame(VirtualMemory *, int);
+static uint64_t makeRoomOnNode(VirtualMemory *, int, int *);
+static uint64_t movePage(VirtualMemory *, int, int);
+static uint64_t swapPages(VirtualMemory *, int, int);
+static uint64_t migrateHotPages(VirtualMemory *);
+static void emitIntervalSample(VirtualMemory *);
+static uint64_t alignCheckpointOffset(uint64_t);
+static int writeCheckpoint(FILE *, VirtualMemory *, uint64_t);
+static int isCheckpointRange(const CheckpointHeader *, uint64_t, uint64_t);
+static int isCheckpointConsistent(const CheckpointHeader *, const char *);
+
+
+/********** LogicalAddress Definitions **********/
+
+typedef struct LogicalAddress {
+    uint16_t address;
+    uint8_t pageNumber;
+    uint8_t offset;
+    int isWrite;
+} LogicalAddress;
+
+static void initLogicalAddress(LogicalAddress *addr, uint64_t vaddr) {
+    assert(addr != 0);
+    uint16_t n = (uint16_t)vaddr;
+    addr->address = n;
+    addr->isWrite = (vaddr & VMM_WRITE_FLAG) != 0;
+    uint8_t msb = (n & PAGE_MASK) >> 8;
+    uint8_t lsb = n & OFFSET_MASK;
+    addr->pageNumber = msb;
+    addr->offset = lsb;
+}
+
+static int isLogicalAddressWrite(LogicalAddress *addr) {
+    assert(addr != 0);
+    return addr->isWrite;
+}
+
+static uint8_t getLogicalAddressPageNumber(LogicalAddress *addr) {
+    assert(addr != 0);
+    return addr->pageNumber;
+}
+
+static uint8_t getLogicalAddressOffset(LogicalAddress *addr) {
+    assert(addr != 0);
+    return addr->offset;
+}
+
+
+/********** Page Definitions **********/
+
+typedef struct Page {
+    int isValid;
+    int isDirty;
+    uint8_t frameNumber;
+    uint64_t lastUsed;
+    uint32_t accessCount;   // references since the last migration scan halved it
+} Page;
+
+static Page *newPage(uint8_t frameNumber) {
+    Page *page = malloc(sizeof(Page));
+    page->isValid = 0;
+    page->isDirty = 0;
+    page->frameNumber = frameNumber;
+    page->lastUsed = 0;
+    page->accessCount = 0;
+    return page;
+}
+
+static int isPageValid(Page *page) {
+    assert(page != 0);
+    return page->isValid;
+}
+
+static void setPageValidation(Page *page, int valid) {
+    assert(page != 0);
+    page->isValid = valid;
+}
+
+static int isPageDirty(Page *page) {
+    assert(page != 0);
+    return page->isDirty;
+}
+
+static void setPageDirty(Page *page, int dirty) {
+    assert(page != 0);
+    page->isDirty = dirty;
+}
+
+static uint8_t getPageFrameNumber(Page *page) {
+    assert(page != 0);
+    return page->frameNumber;
+}
+
+static void setPageFrameNumber(Page *page, uint8_t frameNumber) {
+    assert(page != 0);
+    page->frameNumber = frameNumber;
+}
+
+static uint64_t getPageLastUsed(Page *page) {
+    assert(page != 0);
+    return page->lastUsed;
+}
+
+static void setPageLastUsed(Page *page, uint64_t lastUsed) {
+    assert(page != 0);
+    page->lastUsed = lastUsed;
+}
+
+static uint32_t getPageAccessCount(Page *page) {
+    assert(page != 0);
+    return page->accessCount;
+}
+
+static void setPageAccessCount(Page *page, uint32_t accessCount) {
+    assert(page != 0);
+    page->accessCount = accessCount;
+}
+
+
+/********** PageTable Definitions **********/
+
+typedef struct PageTable {
+    Page **pages;
+} PageTable;
+
+static PageTable *newPageTable(void) {
+    PageTable *table = malloc(sizeof(PageTable));
+    table->pages = malloc(sizeof(Page *) * NUM_PAGES);
+    for (int i = 0; i < NUM_PAGES; ++i) {
+        table->pages[i] = newPage(0);
+    }
+    return table;
+}
+
+static Page *getPageFromPageTable(PageTable *table, int index) {
+    assert(table != 0);
+    assert(index >= 0 && index < NUM_PAGES);
+    return table->pages[index];
+}
+
+static void freePageTable(PageTable *table) {
+    assert(table != 0);
+    for (int i = 0; i < NUM_PAGES; ++i) {
+        free(table->pages[i]);
+    }
+    free(table->pages);
+    free(table);
+}
+
+
+/********** PhysicalMemory Definitions **********/
+
+typedef struct PhysicalMemory {
+    int numFrames;
+    char **memory;
+    int *framePages;        // page that filled the frame, NO_FRAME while free
+    int *frameRefs;         // pages mapped to the frame
+    uint64_t *frameHashes;  // content hash of mergeable frames
+    uint8_t *frameMergeable;
+    uint64_t *frameLoaded;  // clock when the frame was filled
+} PhysicalMemory;
+
+static PhysicalMemory *newPhysicalMemory(int numFrames) {
+    assert(numFrames > 0 && numFrames <= VMM_MAX_FRAMES);
+    PhysicalMemory *mem = malloc(sizeof(PhysicalMemory));
+    mem->numFrames = numFrames;
+    mem->memory = malloc(sizeof(char *) * numFrames);
+    mem->framePages = malloc(sizeof(int) * numFrames);
+    mem->frameRefs = calloc(numFrames, sizeof(int));
+    mem->frameHashes = calloc(numFrames, sizeof(uint64_t));
+    mem->frameMergeable = calloc(numFrames, sizeof(uint8_t));
+    mem->frameLoaded = calloc(numFrames, sizeof(uint64_t));
+    for (int i = 0; i < numFrames; ++i) {
+        mem->memory[i] = malloc(sizeof(char) * FRAME_SIZE);
+        mem->framePages[i] = NO_FRAME;
+    }
+    return mem;
+}
+
+static char *getPhysicalMemoryAtIndex(PhysicalMemory *mem, int index) {
+    assert(mem != 0);
+    assert(index >= 0 && index < mem->numFrames);
+    return mem->memory[index];
+}
+
+static int getPhysicalMemoryValue(PhysicalMemory *mem, int frameNumber, int offset) {
+    assert(mem != 0);
+    assert(frameNumber >= 0 && frameNumber < mem->numFrames);
+    assert(offset >= 0);
+    return mem->memory[frameNumber][offset];
+}
+
+static int getPhysicalMemoryFramePage(PhysicalMemory *mem, int frameNumber) {
+    assert(mem != 0);
+    assert(frameNumber >= 0 && frameNumber < mem->numFrames);
+    return mem->framePages[frameNumber];
+}
+
+static void setPhysicalMemoryFramePage(PhysicalMemory *mem, int frameNumber, int page) {
+    assert(mem != 0);
+    assert(frameNumber >= 0 && frameNumber < mem->numFrames);
+    mem->framePages[frameNumber] = page;
+}
+
+static int getPhysicalMemoryFrameRefs(PhysicalMemory *mem, int frameNumber) {
+    assert(mem != 0);
+    assert(frameNumber >= 0 && frameNumber < mem->numFrames);
+    return mem->frameRefs[frameNumber];
+}
+
+static void setPhysicalMemoryFrameRefs(PhysicalMemory *mem, int frameNumber, int refs) {
+    assert(mem != 0);
+    assert(frameNumber >= 0 && frameNumber < mem->numFrames);
+    mem->frameRefs[frameNumber] = refs;
+}
+
+static int findIdenticalFrame(PhysicalMemory *mem, const char *data, uint64_t hash) {
+    assert(mem != 0);
+    assert(data != 0);
+    // A frame count this small is cheaper to scan than to keep a hash table
+    for (int i = 0; i < mem->numFrames; ++i) {
+        if (mem->frameRefs[i] > 0 && mem->frameMergeable[i] && mem->frameHashes[i] == hash
+                && memcmp(mem->memory[i], data, FRAME_SIZE) == 0) {
+            return i;
+        }
+    }
+    return NO_FRAME;
+}
+
+static void freePhysicalMemory(PhysicalMemory *mem) {
+    assert(mem != 0);
+    for (int i = 0; i < mem->numFrames; ++i) {
+        free(mem->memory[i]);
+    }
+    free(mem->memory);
+    free(mem->framePages);
+    free(mem->frameRefs);
+    free(mem->frameHashes);
+    free(mem->frameMergeable);
+    free(mem->frameLoaded);
+    free(mem);
+}
+
+
+/********** TLBNode Definitions **********/
+
+typedef struct TLBNode {
+    int isValid;
+    uint8_t pageNumber;
+    uint8_t frameNumber;
+} TLBNode;
+
+static TLBNode *newTLBNode(void) {
+    TLBNode *n = malloc(sizeof(TLBNode));
+    invalidateTLBNode(n);
+    return n;
+}
+
+static int isTLBNodeValid(TLBNode *n) {
+    assert(n != 0);
+    return n->isValid;
+}
+
+static void setTLBNode(TLBNode *n, uint8_t page, uint8_t frame) {
+    assert(n != 0);
+    n->isValid = 1;
+    n->pageNumber = page;
+    n->frameNumber = frame;
+}
+
+static void invalidateTLBNode(TLBNode *n) {
+    assert(n != 0);
+    n->isValid = 0;
+    n->pageNumber = 0;
+    n->frameNumber = 0;
+}
+
+
+/********** TLB Definitions **********/
+
+typedef struct TLB {
+    int size;
+    int counter;
+    TLBNode **nodes;
+} TLB;
+
+static TLB *newTLB(int size) {
+    assert(size > 0 && size <= VMM_MAX_TLB_SIZE);
+    TLB *tlb = malloc(sizeof(TLB));
+    tlb->size = size;
+    tlb->counter = 0;
+    tlb->nodes = malloc(sizeof(TLBNode *) * size);
+    for (int i = 0; i < size; ++i) {
+        tlb->nodes[i] = newTLBNode();
+    }
+    return tlb;
+}
+
+static int TLBlookup(TLB *tlb, uint8_t page) {
+    assert(tlb != 0);
+    for (int i = 0; i < tlb->size; ++i) {
+        TLBNode *n = tlb->nodes[i];
+        if (isTLBNodeValid(n) && n->pageNumber == page) {
+            return n->frameNumber;
+        }
+    }
+    return NO_FRAME;
+}
+
+static void updateTLB(TLB *tlb, uint8_t page, uint8_t frame) {
+    assert(tlb != 0);
+    setTLBNode(tlb->nodes[tlb->counter], page, frame);
+    tlb->counter = (tlb->counter + 1) % tlb->size;
+}
+
+static void invalidateTLBPage(TLB *tlb, uint8_t page) {
+    assert(tlb != 0);
+    for (int i = 0; i < tlb->size; ++i) {
+        TLBNode *n = tlb->nodes[i];
+        if (isTLBNodeValid(n) && n->pageNumber == page) {
+            invalidateTLBNode(n);
+        }
+    }
+}
+
+static void freeTLB(TLB *tlb) {
+    assert(tlb != 0);
+    for (int i = 0; i < tlb->size; ++i) {
+        free(tlb->nodes[i]);
+    }
+    free(tlb->nodes);
+    free(tlb);
+}
+
+
+/********** VirtualMemoryConfig Definitions **********/
+
+int initVirtualMemoryConfig(VirtualMemoryConfig *config, ReplacementPolicy policy) {
+    assert(config != 0);
+    if (config->size < VMM_CONFIG_MIN_SIZE || config->size > sizeof(VirtualMemoryConfig)) return 0;
+    VirtualMemoryConfig defaults;
+    defaults.size = config->size;
+    defaults.policy = policy;
+    defaults.numFrames = VMM_MAX_FRAMES;
+    defaults.TLBSize = 16;
+    defaults.backingStorePath = VMM_BACKING_STORE;
+    defaults.TLBLatency = 20;
+    defaults.memoryLatency = 100;
+    defaults.faultLatency = 8000000;
+    defaults.writeBackLatency = 8000000;
+    defaults.compressedPoolBytes = 0;
+    defaults.compressLatency = 4000;
+    defaults.decompressLatency = 2000;
+    defaults.deduplicate = 0;
+    defaults.numNodes = 1;
+    for (int i = 0; i < VMM_MAX_NODES; ++i) {
+        defaults.nodeFrames[i] = 0;
+        defaults.nodeLatency[i] = defaults.memoryLatency;
+    }
+    defaults.placement = FIRST_TOUCH_PLACEMENT;
+    defaults.migrationPeriod = 100;
+    defaults.promoteThreshold = 2;
+    defaults.migrationLatency = 2000;
+    memcpy(config, &defaults, config->size);
+    return 1;
+}
+
+
+/********** VirtualMemory Definitions **********/
+
+typedef struct VirtualMemory {
+    ReplacementPolicy policy;
+    PageTable *pageTable;
+    PhysicalMemory *physicalMemory;
+    TLB *tlb;
+    const char *backingStore;       // mapped read-only, 0 if the file is empty
+    size_t backingStoreSize;
+    int frameCounter;       // frames filled so far, stops at numFrames
+    int fifoHand;           // next FIFO victim once memory is full
+    uint64_t clock;
+    uint64_t TLBLatency;
+    uint64_t memoryLatency;
+    uint64_t faultLatency;
+    uint64_t writeBackLatency;
+    CompressedTier *tier;
+    uint64_t compressLatency;
+    uint64_t decompressLatency;
+    int deduplicate;
+    int numNodes;
+    int nodeStart[VMM_MAX_NODES + 1];       // first frame of each node
+    uint64_t nodeLatency[VMM_MAX_NODES];
+    PlacementPolicy placement;
+    int nextNode;
+    uint64_t migrationPeriod;
+    uint32_t promoteThreshold;
+    uint64_t migrationLatency;
+    uint64_t nextMigration;
+    VirtualMemoryStatistics stats;
+    Profile *profile;
+    IntervalSampler *sampler;
+    uint64_t nextSampleReference;
+    uint64_t nextSampleTime;
+    VirtualMemoryConfig config;     // as created or restored
+} VirtualMemory;
+
+VirtualMemory *newVirtualMemory(const VirtualMemoryConfig *callerConfig) {
+    assert(callerConfig != 0);
+    // Fields the caller's layout predates keep their defaults
+    if (callerConfig->size < VMM_CONFIG_MIN_SIZE || callerConfig->size > sizeof(VirtualMemoryConfig)) return 0;
+    VirtualMemoryConfig fullConfig;
+    fullConfig.size = sizeof(VirtualMemoryConfig);
+    initVirtualMemoryConfig(&fullConfig, callerConfig->policy);
+    memcpy(&fullConfig, callerConfig, callerConfig->size);
+    fullConfig.size = sizeof(VirtualMemoryConfig);
+    const VirtualMemoryConfig *config = &fullConfig;
+    if (config->numFrames <= 0 || config->numFrames > VMM_MAX_FRAMES) return 0;
+    if (config->TLBSize <= 0 || config->TLBSize > VMM_MAX_TLB_SIZE) return 0;
+    if (config->backingStorePath == 0) return 0;
+    if (config->numNodes < 1 || config->numNodes > VMM_MAX_NODES) return 0;
+    if (config->numNodes > 1) {
+        // Nodes split the frames between them, and frames are never shared
+        int total = 0;
+        for (int i = 0; i < config->numNodes; ++i) {
+            if (config->nodeFrames[i] <= 0) return 0;
+            total += config->nodeFrames[i];
+        }
+        if (total != config->numFrames || config->deduplicate) return 0;
+    }
+    // Faults copy straight out of a mapping of the store instead of going
+    // through a seek and a read per page
+    int fd = open(config->backingStorePath, O_RDONLY);
+    if (fd == -1) return 0;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return 0;
+    }
+    size_t backingStoreSize = (uint64_t)st.st_size < (uint64_t)NUM_PAGES * PAGE_SIZE ? (size_t)st.st_size : (size_t)NUM_PAGES * PAGE_SIZE;
+    void *backingStore = 0;
+    if (backingStoreSize > 0) {
+        backingStore = mmap(0, backingStoreSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (backingStore == MAP_FAILED) {
+            close(fd);
+            return 0;
+        }
+    }
+    close(fd);
+    VirtualMemory *vm = malloc(sizeof(VirtualMemory));
+    vm->policy = config->policy;
+    vm->pageTable = newPageTable();
+    vm->physicalMemory = newPhysicalMemory(config->numFrames);
+    vm->tlb = newTLB(config->TLBSize);
+    vm->backingStore = backingStore;
+    vm->backingStoreSize = backingStoreSize;
+    vm->frameCounter = 0;
+    vm->fifoHand = 0;
+    vm->clock = 0;
+    vm->TLBLatency = config->TLBLatency;
+    vm->memoryLatency = config->memoryLatency;
+    vm->faultLatency = config->faultLatency;
+    vm->writeBackLatency = config->writeBackLatency;
+    vm->tier = config->compressedPoolBytes > 0 ? newCompressedTier(config->compressedPoolBytes) : 0;
+    vm->compressLatency = config->compressLatency;
+    vm->decompressLatency = config->decompressLatency;
+    vm->deduplicate = config->deduplicate;
+    vm->numNodes = config->numNodes;
+    vm->nodeStart[0] = 0;
+    for (int i = 0; i < vm->numNodes; ++i) {
+        int frames = vm->numNodes > 1 ? config->nodeFrames[i] : config->numFrames;
+        vm->nodeStart[i + 1] = vm->nodeStart[i] + frames;
+        vm->nodeLatency[i] = vm->numNodes > 1 ? config->nodeLatency[i] : config->memoryLatency;
+    }
+    vm->placement = config->placement;
+    vm->nextNode = 0;
+    vm->migrationPeriod = config->migrationPeriod;
+    vm->promoteThreshold = config->promoteThreshold;
+    vm->migrationLatency = config->migrationLatency;
+    vm->nextMigration = vm->numNodes > 1 && vm->placement == TIERED_PLACEMENT && vm->migrationPeriod > 0 ? vm->migrationPeriod : UINT64_MAX;
+    memset(&vm->stats, 0, sizeof(VirtualMemoryStatistics));
+    vm->stats.size = sizeof(VirtualMemoryStatistics);
+    vm->profile = 0;
+    vm->sampler = 0;
+    vm->nextSampleReference = UINT64_MAX;
+    vm->nextSampleTime = UINT64_MAX;
+    vm->config = *config;
+    return vm;
+}
+
+int translateAddress(VirtualMemory *vm, uint64_t vaddr, uint32_t *paddr, int *value) {
+    assert(vm != 0);
+    LogicalAddress la;
+    initLogicalAddress(&la, vaddr);
+    int outcome = 0;
+    uint8_t frame = resolveFrame(vm, &la, &outcome);
+    if (paddr != 0) {
+        *paddr = translateLogicalToPhysicalAddress(frame, &la);
+    }
+    if (value != 0) {
+        *value = getPhysicalMemoryValue(vm->physicalMemory, frame, getLogicalAddressOffset(&la));
+    }
+    return outcome;
+}
+
+size_t translateBatch(VirtualMemory *vm, const uint64_t *vaddrs, size_t n, uint32_t *paddrs, int *values) {
+    assert(vm != 0);
+    assert(vaddrs != 0 || n == 0);
+    // Resolve in reference order since replacement depends on it, decoding
+    // each address once and only writing the outputs that were asked for
+    PhysicalMemory *mem = vm->physicalMemory;
+    LogicalAddress la;
+    for (size_t i = 0; i < n; ++i) {
+        initLogicalAddress(&la, vaddrs[i]);
+        int outcome = 0;
+        uint8_t frame = resolveFrame(vm, &la, &outcome);
+        if (paddrs != 0) paddrs[i] = translateLogicalToPhysicalAddress(frame, &la);
+        if (values != 0) values[i] = getPhysicalMemoryValue(mem, frame, getLogicalAddressOffset(&la));
+    }
+    return n;
+}
+
+size_t translateRun(VirtualMemory *vm, uint64_t vaddr, size_t count, uint32_t *paddr) {
+    assert(vm != 0);
+    if (count == 0) return 0;
+    // The first reference leaves the page resident and in the TLB, so the
+    // rest of the run are TLB hits that only need accounting. They are
+    // taken in bulk up to the next migration scan or interval sample, and
+    // the caller passes whatever is left back in as a new run.
+    LogicalAddress la;
+    initLogicalAddress(&la, vaddr);
+    int outcome = 0;
+    uint8_t frame = resolveFrame(vm, &la, &outcome);
+    if (paddr != 0) *paddr = translateLogicalToPhysicalAddress(frame, &la);
+    Page *page = getPageFromPageTable(vm->pageTable, getLogicalAddressPageNumber(&la));
+    int node = getFrameNode(vm, frame);
+    uint64_t cost = vm->TLBLatency + vm->nodeLatency[node];
+    uint64_t hits = count - 1;
+    if (vm->nextMigration - vm->stats.numTranslated < hits) hits = vm->nextMigration - vm->stats.numTranslated;
+    if (vm->nextSampleReference - vm->stats.numTranslated - 1 < hits) hits = vm->nextSampleReference - vm->stats.numTranslated - 1;
+    if (vm->nextSampleTime != UINT64_MAX && cost > 0) {
+        uint64_t room = vm->nextSampleTime - vm->stats.simulatedTime - 1;
+        if (room / cost < hits) hits = room / cost;
+    }
+    vm->clock += hits;
+    if (hits > 0) setPageLastUsed(page, vm->clock - 1);
+    uint64_t accessCount = getPageAccessCount(page) + hits;
+    setPageAccessCount(page, accessCount < UINT32_MAX ? (uint32_t)accessCount : UINT32_MAX);
+    vm->stats.numTranslated += hits;
+    vm->stats.numTLBhits += hits;
+    vm->stats.simulatedTime += hits * cost;
+    vm->stats.memoryAccessTime += hits * vm->nodeLatency[node];
+    vm->stats.nodeAccesses[node] += hits;
+    return hits + 1;
+}
+
+int getVirtualMemoryValue(VirtualMemory *vm, uint32_t paddr, int *value) {
+    assert(vm != 0);
+    assert(value != 0);
+    PhysicalMemory *mem = vm->physicalMemory;
+    if (paddr / FRAME_SIZE >= (uint32_t)mem->numFrames) return 0;
+    *value = getPhysicalMemoryValue(mem, paddr / FRAME_SIZE, paddr % FRAME_SIZE);
+    return 1;
+}
+
+int getVirtualMemoryStatistics(VirtualMemory *vm, VirtualMemoryStatistics *stats) {
+    assert(vm != 0);
+    assert(stats != 0);
+    if (stats->size < VMM_STATISTICS_MIN_SIZE || stats->size > sizeof(VirtualMemoryStatistics)) return 0;
+    uint32_t size = stats->size;
+    memcpy(stats, &vm->stats, size);
+    stats->size = size;
+    return 1;
+}
+
+int getVirtualMemoryConfig(VirtualMemory *vm, VirtualMemoryConfig *config) {
+    assert(vm != 0);
+    assert(config != 0);
+    if (config->size < VMM_CONFIG_MIN_SIZE || config->size > sizeof(VirtualMemoryConfig)) return 0;
+    uint32_t size = config->size;
+    memcpy(config, &vm->config, size);
+    config->size = size;
+    return 1;
+}
+
+void setVirtualMemoryProfile(VirtualMemory *vm, Profile *profile) {
+    assert(vm != 0);
+    vm->profile = profile;
+}
+
+void setVirtualMemorySampler(VirtualMemory *vm, IntervalSampler *sampler) {
+    assert(vm != 0);
+    vm->sampler = sampler;
+    vm->nextSampleReference = UINT64_MAX;
+    vm->nextSampleTime = UINT64_MAX;
+    if (sampler == 0) return;
+    // Intervals are counted from the moment the sampler is attached
+    uint64_t references = getIntervalSamplerReferences(sampler);
+    uint64_t quantum = getIntervalSamplerQuantum(sampler);
+    if (references > 0) vm->nextSampleReference = vm->stats.numTranslated + references;
+    if (quantum > 0) vm->nextSampleTime = vm->stats.simulatedTime + quantum;
+    pushIntervalSample(sampler, &vm->stats);
+}
+
+void sampleVirtualMemory(VirtualMemory *vm) {
+    assert(vm != 0);
+    if (vm->sampler != 0) pushIntervalSample(vm->sampler, &vm->stats);
+}
+
+void freeVirtualMemory(VirtualMemory *vm) {
+    assert(vm != 0);
+    freePageTable(vm->pageTable);
+    freePhysicalMemory(vm->physicalMemory);
+    freeTLB(vm->tlb);
+    if (vm->tier != 0) freeCompressedTier(vm->tier);
+    if (vm->backingStore != 0) munmap((void *)vm->backingStore, vm->backingStoreSize);
+    free(vm);
+}
+
+
+/********** Checkpoint Definitions **********/
+
+// A checkpoint is the header followed by the page table, TLB and frame
+// owner arrays, then the frame contents on a page aligned offset so the
+// file can be mapped and copied straight into PhysicalMemory. The
+// compressed tier image, if any, follows the frames.
+typedef struct CheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t policy;
+    int32_t numFrames;
+    int32_t TLBSize;
+    int32_t TLBCounter;
+    int32_t frameCounter;
+    int32_t residentPages;
+    int32_t fifoHand;
+    int32_t reserved;
+    uint64_t clock;
+    uint64_t TLBLatency;
+    uint64_t memoryLatency;
+    uint64_t faultLatency;
+    uint64_t writeBackLatency;
+    uint64_t traceOffset;
+    uint64_t numTranslated;
+    uint64_t numPageFaults;
+    uint64_t numTLBhits;
+    uint64_t numEvictions;
+    uint64_t numWriteBacks;
+    uint64_t simulatedTime;
+    uint64_t compressedPoolBytes;
+    uint64_t compressLatency;
+    uint64_t decompressLatency;
+    uint64_t numTierStores;
+    uint64_t numTierRejects;
+    uint64_t numTierHits;
+    uint64_t numTierEvictions;
+    uint64_t tierUncompressedBytes;
+    uint64_t tierCompressedBytes;
+    int64_t tierTimeSaved;
+    uint32_t deduplicate;
+    int32_t peakFramesSaved;
+    uint64_t numMergedPages;
+    uint64_t numCopyOnWrites;
+    int32_t numNodes;
+    uint32_t placement;
+    int32_t nodeFrames[VMM_MAX_NODES];
+    uint64_t nodeLatency[VMM_MAX_NODES];
+    int32_t nextNode;
+    uint32_t promoteThreshold;
+    uint64_t migrationPeriod;
+    uint64_t migrationLatency;
+    uint64_t nextMigration;
+    uint64_t memoryAccessTime;
+    uint64_t nodeAccesses[VMM_MAX_NODES];
+    uint64_t nodePromotions[VMM_MAX_NODES];
+    uint64_t nodeDemotions[VMM_MAX_NODES];
+    uint64_t pageTableOffset;
+    uint64_t framesOffset;
+    uint64_t TLBOffset;
+    uint64_t framePagesOffset;
+    uint64_t memoryOffset;
+    uint64_t tierOffset;
+    uint64_t tierSize;
+    uint64_t fileSize;
+} CheckpointHeader;
+
+typedef struct CheckpointPage {
+    uint8_t isValid;
+    uint8_t isDirty;
+    uint8_t frameNumber;
+    uint8_t reserved;
+    uint32_t accessCount;
+    uint64_t lastUsed;
+} CheckpointPage;
+
+typedef struct CheckpointTLBNode {
+    uint8_t isValid;
+    uint8_t pageNumber;
+    uint8_t frameNumber;
+    uint8_t reserved;
+} CheckpointTLBNode;
+
+// Reference counts and hashes are rebuilt from the page table and frame
+// contents, only what cannot be recomputed is kept per frame
+typedef struct CheckpointFrame {
+    uint64_t loaded;
+    uint8_t isMergeable;
+    uint8_t reserved[7];
+} CheckpointFrame;
+
+int saveVirtualMemory(VirtualMemory *vm, const char *path, uint64_t traceOffset) {
+    assert(vm != 0);
+    assert(path != 0);
+    // Write beside the target and rename so an interrupted save never
+    // clobbers the previous checkpoint
+    size_t len = strlen(path);
+    char *tmpPath = malloc(len + 5);
+    memcpy(tmpPath, path, len);
+    memcpy(tmpPath + len, ".tmp", 5);
+    FILE *fp = fopen(tmpPath, "wb");
+    int ok = fp != 0 && writeCheckpoint(fp, vm, traceOffset);
+    if (fp != 0 && fclose(fp) != 0) ok = 0;
+    if (ok && rename(tmpPath, path) != 0) ok = 0;
+    if (!ok) remove(tmpPath);
+    free(tmpPath);
+    return ok;
+}
+
+VirtualMemory *restoreVirtualMemory(const char *path, const char *backingStorePath, uint64_t *traceOffset) {
+    assert(path != 0);
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) return 0;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < sizeof(CheckpointHeader)) {
+        close(fd);
+        return 0;
+    }
+    void *map = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return 0;
+    const char *base = map;
+    const CheckpointHeader *h = map;
+    VirtualMemory *vm = 0;
+    if (memcmp(h->magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0
+            || h->version != CHECKPOINT_VERSION
+            || h->headerSize != sizeof(CheckpointHeader)
+            || h->fileSize != (uint64_t)st.st_size
+            || h->policy > LRU_REPLACEMENT
+            || h->placement > TIERED_PLACEMENT
+            || h->numNodes < 1 || h->numNodes > VMM_MAX_NODES
+            || h->nextNode < 0 || h->nextNode >= h->numNodes
+            || h->numFrames <= 0 || h->numFrames > VMM_MAX_FRAMES
+            || h->TLBSize <= 0 || h->TLBSize > VMM_MAX_TLB_SIZE
+            || h->TLBCounter < 0 || h->TLBCounter >= h->TLBSize
+            || h->frameCounter < 0 || h->frameCounter > h->numFrames
+            || h->fifoHand < 0 || h->fifoHand >= h->numFrames
+            // Each table must fit in the file before the next one is placed
+            // after it, so none of the ends below can wrap
+            || h->pageTableOffset < sizeof(CheckpointHeader)
+            || !isCheckpointRange(h, h->pageTableOffset, sizeof(CheckpointPage) * NUM_PAGES)
+            || h->framesOffset < h->pageTableOffset + sizeof(CheckpointPage) * NUM_PAGES
+            || !isCheckpointRange(h, h->framesOffset, sizeof(CheckpointFrame) * h->numFrames)
+            || h->TLBOffset < h->framesOffset + sizeof(CheckpointFrame) * h->numFrames
+            || !isCheckpointRange(h, h->TLBOffset, sizeof(CheckpointTLBNode) * h->TLBSize)
+            || h->framePagesOffset < h->TLBOffset + sizeof(CheckpointTLBNode) * h->TLBSize
+            || !isCheckpointRange(h, h->framePagesOffset, sizeof(int32_t) * h->numFrames)
+            || h->memoryOffset < h->framePagesOffset + sizeof(int32_t) * h->numFrames
+            || !isCheckpointRange(h, h->memoryOffset, (uint64_t)h->numFrames * FRAME_SIZE)
+            || h->tierOffset < h->memoryOffset + (uint64_t)h->numFrames * FRAME_SIZE
+            || !isCheckpointRange(h, h->tierOffset, h->tierSize)
+            || h->tierOffset + h->tierSize != h->fileSize
+            || (h->tierSize > 0) != (h->compressedPoolBytes > 0)
+            || !isCheckpointConsistent(h, base)) {
+        munmap(map, st.st_size);
+        return 0;
+    }
+
+    VirtualMemoryConfig config;
+    config.size = sizeof(config);
+    initVirtualMemoryConfig(&config, (ReplacementPolicy)h->policy);
+    config.numFrames = h->numFrames;
+    config.TLBSize = h->TLBSize;
+    if (backingStorePath != 0) config.backingStorePath = backingStorePath;
+    config.TLBLatency = h->TLBLatency;
+    config.memoryLatency = h->memoryLatency;
+    config.faultLatency = h->faultLatency;
+    config.writeBackLatency = h->writeBackLatency;
+    config.compressedPoolBytes = h->compressedPoolBytes;
+    config.compressLatency = h->compressLatency;
+    config.decompressLatency = h->decompressLatency;
+    config.deduplicate = h->deduplicate != 0;
+    config.numNodes = h->numNodes;
+    for (int i = 0; i < VMM_MAX_NODES; ++i) {
+        config.nodeFrames[i] = h->nodeFrames[i];
+        config.nodeLatency[i] = h->nodeLatency[i];
+    }
+    config.placement = (PlacementPolicy)h->placement;
+    config.migrationPeriod = h->migrationPeriod;
+    config.promoteThreshold = h->promoteThreshold;
+    config.migrationLatency = h->migrationLatency;
+    vm = newVirtualMemory(&config);
+    if (vm != 0 && vm->tier != 0) {
+        freeCompressedTier(vm->tier);
+        vm->tier = readCompressedTier(base + h->tierOffset, h->tierSize);
+        if (vm->tier == 0) {
+            freeVirtualMemory(vm);
+            vm = 0;
+        }
+    }
+    if (vm != 0) {
+        const CheckpointPage *pages = (const CheckpointPage *)(base + h->pageTableOffset);
+        for (int i = 0; i < NUM_PAGES; ++i) {
+            Page *page = getPageFromPageTable(vm->pageTable, i);
+            setPageValidation(page, pages[i].isValid);
+            setPageDirty(page, pages[i].isDirty);
+            setPageFrameNumber(page, pages[i].frameNumber);
+            setPageLastUsed(page, pages[i].lastUsed);
+            setPageAccessCount(page, pages[i].accessCount);
+        }
+        const CheckpointTLBNode *nodes = (const CheckpointTLBNode *)(base + h->TLBOffset);
+        for (int i = 0; i < h->TLBSize; ++i) {
+            if (nodes[i].isValid) setTLBNode(vm->tlb->nodes[i], nodes[i].pageNumber, nodes[i].frameNumber);
+        }
+        vm->tlb->counter = h->TLBCounter;
+        PhysicalMemory *mem = vm->physicalMemory;
+        const int32_t *framePages = (const int32_t *)(base + h->framePagesOffset);
+        const CheckpointFrame *frames = (const CheckpointFrame *)(base + h->framesOffset);
+        for (int i = 0; i < h->numFrames; ++i) {
+            setPhysicalMemoryFramePage(mem, i, framePages[i]);
+            memcpy(getPhysicalMemoryAtIndex(mem, i), base + h->memoryOffset + (uint64_t)i * FRAME_SIZE, FRAME_SIZE);
+            mem->frameHashes[i] = hashFrame(getPhysicalMemoryAtIndex(mem, i));
+            mem->frameMergeable[i] = frames[i].isMergeable;
+            mem->frameLoaded[i] = frames[i].loaded;
+        }
+        for (int i = 0; i < NUM_PAGES; ++i) {
+            Page *page = getPageFromPageTable(vm->pageTable, i);
+            if (!isPageValid(page)) continue;
+            int frame = getPageFrameNumber(page);
+            if (getPhysicalMemoryFrameRefs(mem, frame) == 0) vm->stats.framesInUse++;
+            setPhysicalMemoryFrameRefs(mem, frame, getPhysicalMemoryFrameRefs(mem, frame) + 1);
+        }
+        vm->frameCounter = h->frameCounter;
+        vm->fifoHand = h->fifoHand;
+        vm->clock = h->clock;
+        vm->stats.numTranslated = h->numTranslated;
+        vm->stats.numPageFaults = h->numPageFaults;
+        vm->stats.numTLBhits = h->numTLBhits;
+        vm->stats.numEvictions = h->numEvictions;
+        vm->stats.numWriteBacks = h->numWriteBacks;
+        vm->stats.simulatedTime = h->simulatedTime;
+        vm->stats.residentPages = h->residentPages;
+        vm->stats.numTierStores = h->numTierStores;
+        vm->stats.numTierRejects = h->numTierRejects;
+        vm->stats.numTierHits = h->numTierHits;
+        vm->stats.numTierEvictions = h->numTierEvictions;
+        vm->stats.tierUncompressedBytes = h->tierUncompressedBytes;
+        vm->stats.tierCompressedBytes = h->tierCompressedBytes;
+        vm->stats.tierTimeSaved = h->tierTimeSaved;
+        vm->stats.numMergedPages = h->numMergedPages;
+        vm->stats.numCopyOnWrites = h->numCopyOnWrites;
+        vm->stats.peakFramesSaved = h->peakFramesSaved;
+        vm->stats.memoryAccessTime = h->memoryAccessTime;
+        for (int i = 0; i < VMM_MAX_NODES; ++i) {
+            vm->stats.nodeAccesses[i] = h->nodeAccesses[i];
+            vm->stats.nodePromotions[i] = h->nodePromotions[i];
+            vm->stats.nodeDemotions[i] = h->nodeDemotions[i];
+        }
+        vm->nextNode = h->nextNode;
+        vm->nextMigration = h->nextMigration;
+        if (traceOffset != 0) *traceOffset = h->traceOffset;
+    }
+    munmap(map, st.st_size);
+    return vm;
+}
+
+
+/*********** Function Definitions ***********/
+
+const char *getReplacementPolicyName(ReplacementPolicy policy) {
+    switch (policy) {
+        case FIFO_REPLACEMENT:  return "fifo";
+        case LRU_REPLACEMENT:   return "lru";
+    }
+    return "unknown";
+}
+
+const char *getPlacementPolicyName(PlacementPolicy placement) {
+    switch (placement) {
+        case FIRST_TOUCH_PLACEMENT: return "first-touch";
+        case INTERLEAVE_PLACEMENT:  return "interleave";
+        case TIERED_PLACEMENT:      return "tiered";
+    }
+    return "unknown";
+}
+
+int parsePlacementPolicy(const char *name, PlacementPolicy *placement) {
+    assert(name != 0);
+    assert(placement != 0);
+    for (int i = FIRST_TOUCH_PLACEMENT; i <= TIERED_PLACEMENT; ++i) {
+        if (strcmp(name, getPlacementPolicyName((PlacementPolicy)i)) == 0) {
+            *placement = (PlacementPolicy)i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void printStatistics(FILE *fp, const VirtualMemoryStatistics *stats) {
+    assert(stats != 0);
+    assert(stats->size >= VMM_STATISTICS_MIN_SIZE);
+    fprintf(fp, "Number of Translated Addresses = %" PRIu64 "\n", stats->numTranslated);
+    fprintf(fp, "Page Faults = %" PRIu64 "\n", stats->numPageFaults);
+    fprintf(fp, "Page Fault Rate = %.3f\n", (float)(stats->numPageFaults) / stats->numTranslated);
+    fprintf(fp, "TLB Hits = %" PRIu64 "\n", stats->numTLBhits);
+    fprintf(fp, "TLB Hit Rate = %.3f\n", (float)(stats->numTLBhits) / stats->numTranslated);
+}
+
+void printTierStatistics(FILE *fp, const VirtualMemoryStatistics *stats) {
+    assert(stats != 0);
+    assert(stats->size >= VMM_STATISTICS_MIN_SIZE);
+    double ratio = stats->tierCompressedBytes > 0 ? (double)stats->tierUncompressedBytes / stats->tierCompressedBytes : 0;
+    double hitRate = stats->numPageFaults > 0 ? (double)stats->numTierHits / stats->numPageFaults : 0;
+    fprintf(fp, "Compressed Tier Stores = %" PRIu64 "\n", stats->numTierStores);
+    fprintf(fp, "Compressed Tier Rejects = %" PRIu64 "\n", stats->numTierRejects);
+    fprintf(fp, "Compressed Tier Evictions = %" PRIu64 "\n", stats->numTierEvictions);
+    fprintf(fp, "Compressed Tier Hits = %" PRIu64 "\n", stats->numTierHits);
+    fprintf(fp, "Compressed Tier Hit Rate = %.3f\n", hitRate);
+    fprintf(fp, "Compression Ratio = %.3f\n", ratio);
+    fprintf(fp, "Compressed Tier Time Saved = %" PRId64 " ns\n", stats->tierTimeSaved);
+}
+
+void printDedupStatistics(FILE *fp, const VirtualMemoryStatistics *stats, const VirtualMemoryStatistics *baseline) {
+    assert(stats != 0);
+    assert(stats->size >= VMM_STATISTICS_MIN_SIZE);
+    // Effective capacity is resident pages per frame actually holding them
+    double capacity = stats->framesInUse > 0 ? (double)stats->residentPages / stats->framesInUse : 1;
+    fprintf(fp, "Merged Pages = %" PRIu64 "\n", stats->numMergedPages);
+    fprintf(fp, "Copy-on-Write Faults = %" PRIu64 "\n", stats->numCopyOnWrites);
+    fprintf(fp, "Frames Saved = %d (peak %d)\n", stats->residentPages - stats->framesInUse, stats->peakFramesSaved);
+    fprintf(fp, "Effective Capacity = %.3fx\n", capacity);
+    if (baseline == 0 || baseline->numTranslated == 0 || stats->numTranslated == 0) return;
+    double rate = (double)stats->numPageFaults / stats->numTranslated;
+    double baselineRate = (double)baseline->numPageFaults / baseline->numTranslated;
+    fprintf(fp, "Page Fault Rate Without Dedup = %.3f (%+.3f)\n", baselineRate, rate - baselineRate);
+}
+
+void printNodeStatistics(FILE *fp, const VirtualMemoryStatistics *stats, const VirtualMemoryStatistics *baseline) {
+    assert(stats != 0);
+    assert(stats->size >= VMM_STATISTICS_MIN_SIZE);
+    if (stats->numTranslated == 0) return;
+    for (int i = 0; i < VMM_MAX_NODES; ++i) {
+        if (stats->nodeAccesses[i] == 0 && stats->nodePromotions[i] == 0 && stats->nodeDemotions[i] == 0) continue;
+        fprintf(fp, "Node %d Accesses = %" PRIu64 " (%.3f)\n", i, stats->nodeAccesses[i], (double)stats->nodeAccesses[i] / stats->numTranslated);
+        fprintf(fp, "Node %d Promotions In = %" PRIu64 "\n", i, stats->nodePromotions[i]);
+        fprintf(fp, "Node %d Demotions Out = %" PRIu64 "\n", i, stats->nodeDemotions[i]);
+    }
+    double latency = (double)stats->memoryAccessTime / stats->numTranslated;
+    fprintf(fp, "Average Access Latency = %.1f ns\n", latency);
+    if (baseline == 0 || baseline->numTranslated == 0) return;
+    double baselineLatency = (double)baseline->memoryAccessTime / baseline->numTranslated;
+    fprintf(fp, "Average Access Latency With Interleave = %.1f ns (saved %.1f%%)\n", baselineLatency,
+            baselineLatency > 0 ? 100 * (baselineLatency - latency) / baselineLatency : 0);
+    fprintf(fp, "Number of Page Faults With Interleave = %" PRIu64 "\n", baseline->numPageFaults);
+}
+
+static uint32_t translateLogicalToPhysicalAddress(uint8_t frame, LogicalAddress *logicalAddress) {
+    assert(logicalAddress != 0);
+    return frame * FRAME_SIZE + getLogicalAddressOffset(logicalAddress);
+}
+
+static uint8_t resolveFrame(VirtualMemory *vm, LogicalAddress *la, int *outcome) {
+    uint8_t pageNumber = getLogicalAddressPageNumber(la);
+    Page *page = getPageFromPageTable(vm->pageTable, pageNumber);
+    // Migrate between references so no frame moves under a caller
+    uint64_t migrationCost = 0;
+    if (vm->stats.numTranslated >= vm->nextMigration) {
+        migrationCost = migrateHotPages(vm);
+        vm->nextMigration += vm->migrationPeriod;
+    }
+    // Check TLB for page
+    Profile *sampled = PROFILE_SAMPLED(vm->profile, vm->clock);
+    PROFILE_MARK(sampled, mark);
+    int TLBframe = TLBlookup(vm->tlb, pageNumber);
+    PROFILE_SCALED(sampled, TLB_PHASE, mark);
+    uint8_t currFrame = 0;
+    uint64_t cost = vm->TLBLatency + migrationCost;
+    if (TLBframe != NO_FRAME) {
+        // TLB Hit
+        currFrame = TLBframe;
+        vm->stats.numTLBhits++;
+        *outcome |= VMM_TLB_HIT;
+    }
+    else {
+        if (!isPageValid(page)) {
+            // Page Fault
+            PROFILE_MARK(vm->profile, faultMark);
+            cost += handlePageFault(vm, pageNumber);
+            PROFILE_FAULT(vm->profile, faultMark, mark);
+            vm->stats.numPageFaults++;
+            *outcome |= VMM_PAGE_FAULT;
+        }
+        // Get frame and update TLB
+        currFrame = getPageFrameNumber(page);
+        updateTLB(vm->tlb, pageNumber, currFrame);
+        cost += vm->memoryLatency;
+        PROFILE_SCALED(sampled, PAGE_TABLE_PHASE, mark);
+    }
+    if (isLogicalAddressWrite(la)) {
+        if (vm->deduplicate) {
+            cost += copyOnWrite(vm, pageNumber);
+            if (getPageFrameNumber(page) != currFrame) {
+                currFrame = getPageFrameNumber(page);
+                updateTLB(vm->tlb, pageNumber, currFrame);
+            }
+        }
+        setPageDirty(page, 1);
+    }
+    int node = getFrameNode(vm, currFrame);
+    cost += vm->nodeLatency[node];
+    vm->stats.memoryAccessTime += vm->nodeLatency[node];
+    vm->stats.nodeAccesses[node]++;
+    if (getPageAccessCount(page) < UINT32_MAX) setPageAccessCount(page, getPageAccessCount(page) + 1);
+    setPageLastUsed(page, vm->clock);
+    vm->clock++;
+    vm->stats.numTranslated++;
+    vm->stats.simulatedTime += cost;
+    if (vm->stats.numTranslated >= vm->nextSampleReference || vm->stats.simulatedTime >= vm->nextSampleTime) {
+        emitIntervalSample(vm);
+    }
+    return currFrame;
+}
+
+static int selectVictimFrame(VirtualMemory *vm) {
+    switch (vm->policy) {
+        case LRU_REPLACEMENT:
+            return getPageFrameNumber(getPageFromPageTable(vm->pageTable, getLRUindex(vm->pageTable)));
+        case FIFO_REPLACEMENT:
+        default: {
+            int victim = vm->fifoHand;
+            vm->fifoHand = (vm->fifoHand + 1) % vm->physicalMemory->numFrames;
+            return victim;
+        }
+    }
+}
+
+static int getLRUindex(PageTable *pageTable) {
+    assert(pageTable != 0);
+    int index = -1;
+    uint64_t lastUsed = 0;
+    for (int i = 0; i < NUM_PAGES; ++i) {
+        Page *page = getPageFromPageTable(pageTable, i);
+        if (isPageValid(page) && (index == -1 || getPageLastUsed(page) < lastUsed)) {
+            lastUsed = getPageLastUsed(page);
+            index = i;
+        }
+    }
+    return index;
+}
+
+static uint64_t handlePageFault(VirtualMemory *vm, uint8_t pageNumber) {
+    assert(vm != 0);
+    if (vm->deduplicate) return handleMergingPageFault(vm, pageNumber);
+    if (vm->numNodes > 1) return handleNodePageFault(vm, pageNumber);
+    PhysicalMemory *mem = vm->physicalMemory;
+    uint64_t cost = 0;
+    int location = vm->frameCounter;
+    if (location < mem->numFrames) {
+        vm->frameCounter++;
+    }
+    else {
+        // Memory is full, evict the policy's victim
+        location = selectVictimFrame(vm);
+        cost += evictPage(vm, getPhysicalMemoryFramePage(mem, location));
+    }
+    int dirty = 0;
+    cost += loadPage(vm, pageNumber, getPhysicalMemoryAtIndex(mem, location), &dirty);
+    mapPage(vm, pageNumber, location, dirty);
+    return cost;
+}
+
+static uint64_t handleMergingPageFault(VirtualMemory *vm, uint8_t pageNumber) {
+    PhysicalMemory *mem = vm->physicalMemory;
+    // The contents decide the frame, so load them before picking one
+    char buffer[FRAME_SIZE];
+    int dirty = 0;
+    uint64_t cost = loadPage(vm, pageNumber, buffer, &dirty);
+    uint64_t hash = hashFrame(buffer);
+    // A dirty page coming back from the tier was written, and writes are
+    // not simulated, so it never matches another frame
+    int frame = dirty ? NO_FRAME : findIdenticalFrame(mem, buffer, hash);
+    if (frame != NO_FRAME) {
+        vm->stats.numMergedPages++;
+    }
+    else {
+        cost += allocateFrame(vm, &frame);
+        memcpy(getPhysicalMemoryAtIndex(mem, frame), buffer, FRAME_SIZE);
+        mem->frameHashes[frame] = hash;
+        mem->frameMergeable[frame] = !dirty;
+    }
+    mapPage(vm, pageNumber, frame, dirty);
+    return cost;
+}
+
+static uint64_t allocateFrame(VirtualMemory *vm, int *frame) {
+    PhysicalMemory *mem = vm->physicalMemory;
+    if (vm->frameCounter < mem->numFrames) {
+        *frame = vm->frameCounter++;
+        return 0;
+    }
+    // Copy-on-write and shared evictions can leave frames free in any order
+    for (int i = 0; i < mem->numFrames; ++i) {
+        if (getPhysicalMemoryFrameRefs(mem, i) == 0) {
+            *frame = i;
+            return 0;
+        }
+    }
+    // Memory is full, evict every page sharing the policy's victim
+    int victim = selectSharedVictimFrame(vm);
+    uint64_t cost = 0;
+    for (int i = 0; i < NUM_PAGES && getPhysicalMemoryFrameRefs(mem, victim) > 0; ++i) {
+        Page *page = getPageFromPageTable(vm->pageTable, i);
+        if (isPageValid(page) && getPageFrameNumber(page) == victim) cost += evictPage(vm, i);
+    }
+    *frame = victim;
+    return cost;
+}
+
+static int selectSharedVictimFrame(VirtualMemory *vm) {
+    PhysicalMemory *mem = vm->physicalMemory;
+    // FIFO goes by when a frame was filled, LRU by the latest use of any
+    // page sharing it
+    uint64_t recency[VMM_MAX_FRAMES];
+    for (int i = 0; i < mem->numFrames; ++i) recency[i] = mem->frameLoaded[i];
+    if (vm->policy == LRU_REPLACEMENT) {
+        for (int i = 0; i < mem->numFrames; ++i) recency[i] = 0;
+        for (int i = 0; i < NUM_PAGES; ++i) {
+            Page *page = getPageFromPageTable(vm->pageTable, i);
+            if (isPageValid(page) && getPageLastUsed(page) >= recency[getPageFrameNumber(page)]) {
+                recency[getPageFrameNumber(page)] = getPageLastUsed(page);
+            }
+        }
+    }
+    int victim = NO_FRAME;
+    for (int i = 0; i < mem->numFrames; ++i) {
+        if (getPhysicalMemoryFrameRefs(mem, i) > 0 && (victim == NO_FRAME || recency[i] < recency[victim])) victim = i;
+    }
+    return victim;
+}
+
+static uint64_t copyOnWrite(VirtualMemory *vm, uint8_t pageNumber) {
+    PhysicalMemory *mem = vm->physicalMemory;
+    Page *page = getPageFromPageTable(vm->pageTable, pageNumber);
+    int shared = getPageFrameNumber(page);
+    if (getPhysicalMemoryFrameRefs(mem, shared) == 1) {
+        // Sole owner, the frame only stops being a merge target
+        mem->frameMergeable[shared] = 0;
+        return 0;
+    }
+    // Copy out first, making room may evict the other sharers
+    char buffer[FRAME_SIZE];
+    memcpy(buffer, getPhysicalMemoryAtIndex(mem, shared), FRAME_SIZE);
+    int dirty = isPageDirty(page);
+    unmapPage(vm, pageNumber);
+    int frame;
+    uint64_t cost = allocateFrame(vm, &frame) + vm->memoryLatency;
+    memcpy(getPhysicalMemoryAtIndex(mem, frame), buffer, FRAME_SIZE);
+    mem->frameMergeable[frame] = 0;
+    mapPage(vm, pageNumber, frame, dirty);
+    vm->stats.numCopyOnWrites++;
+    return cost;
+}
+
+static int getFrameNode(VirtualMemory *vm, int frame) {
+    int node = 0;
+    while (node < vm->numNodes - 1 && frame >= vm->nodeStart[node + 1]) node++;
+    return node;
+}
+
+static int findFreeFrame(VirtualMemory *vm, int node) {
+    for (int i = vm->nodeStart[node]; i < vm->nodeStart[node + 1]; ++i) {
+        if (getPhysicalMemoryFrameRefs(vm->physicalMemory, i) == 0) return i;
+    }
+    return NO_FRAME;
+}
+
+static uint64_t handleNodePageFault(VirtualMemory *vm, uint8_t pageNumber) {
+    PhysicalMemory *mem = vm->physicalMemory;
+    int node = selectPlacementNode(vm);
+    int frame = node == ANY_NODE ? NO_FRAME : findFreeFrame(vm, node);
+    uint64_t cost = 0;
+    if (frame == NO_FRAME) {
+        if (vm->placement == TIERED_PLACEMENT) {
+            // New pages land in the top tier and push its coldest page down
+            cost += makeRoomOnNode(vm, node, &frame);
+        }
+        else {
+            // Every node is full by now, so reclaim the oldest page on
+            // whichever node holds it
+            frame = selectNodeVictimFrame(vm, node);
+            cost += evictPage(vm, getPhysicalMemoryFramePage(mem, frame));
+        }
+    }
+    int dirty = 0;
+    cost += loadPage(vm, pageNumber, getPhysicalMemoryAtIndex(mem, frame), &dirty);
+    mapPage(vm, pageNumber, frame, dirty);
+    return cost;
+}
+
+static int selectPlacementNode(VirtualMemory *vm) {
+    switch (vm->placement) {
+        case INTERLEAVE_PLACEMENT: {
+            int node = vm->nextNode;
+            vm->nextNode = (vm->nextNode + 1) % vm->numNodes;
+            // Like Linux, a full node passes the page on to the next node
+            // with a free frame, and only reclaims once every node is full
+            for (int i = 0; i < vm->numNodes; ++i) {
+                int candidate = (node + i) % vm->numNodes;
+                if (findFreeFrame(vm, candidate) != NO_FRAME) return candidate;
+            }
+            return ANY_NODE;
+        }
+        case TIERED_PLACEMENT:
+            return 0;
+        case FIRST_TOUCH_PLACEMENT:
+        default:
+            // The simulated thread runs on node 0 and falls back to the other
+            // nodes in order only while they still have free frames
+            for (int node = 0; node < vm->numNodes; ++node) {
+                if (findFreeFrame(vm, node) != NO_FRAME) return node;
+            }
+            return ANY_NODE;
+    }
+}
+
+static int selectNodeVictimFrame(VirtualMemory *vm, int node) {
+    PhysicalMemory *mem = vm->physicalMemory;
+    int victim = NO_FRAME;
+    uint64_t oldest = 0;
+    int first = node == ANY_NODE ? 0 : vm->nodeStart[node];
+    int last = node == ANY_NODE ? vm->nodeStart[vm->numNodes] : vm->nodeStart[node + 1];
+    for (int i = first; i < last; ++i) {
+        if (getPhysicalMemoryFrameRefs(mem, i) == 0) continue;
+        uint64_t age = mem->frameLoaded[i];
+        if (vm->policy == LRU_REPLACEMENT) {
+            age = getPageLastUsed(getPageFromPageTable(vm->pageTable, getPhysicalMemoryFramePage(mem, i)));
+        }
+        if (victim == NO_FRAME || age < oldest) {
+            victim = i;
+            oldest = age;
+        }
+    }
+    return victim;
+}
+
+static uint64_t makeRoomOnNode(VirtualMemory *vm, int node, int *frame) {
+    PhysicalMemory *mem = vm->physicalMemory;
+    *frame = findFreeFrame(vm, node);
+    if (*frame != NO_FRAME) return 0;
+    *frame = selectNodeVictimFrame(vm, node);
+    int victim = getPhysicalMemoryFramePage(mem, *frame);
+    // Only the lowest tier evicts to the backing store
+    if (node == vm->numNodes - 1) return evictPage(vm, victim);
+    int lower;
+    uint64_t cost = makeRoomOnNode(vm, node + 1, &lower);
+    cost += movePage(vm, victim, lower);
+    vm->stats.nodeDemotions[node]++;
+    return cost;
+}
+
+static uint64_t movePage(VirtualMemory *vm, int pageNumber, int frame) {
+    PhysicalMemory *mem = vm->physicalMemory;
+    Page *page = getPageFromPageTable(vm->pageTable, pageNumber);
+    int dirty = isPageDirty(page);
+    memcpy(getPhysicalMemoryAtIndex(mem, frame), getPhysicalMemoryAtIndex(mem, getPageFrameNumber(page)), FRAME_SIZE);
+    unmapPage(vm, pageNumber);
+    mapPage(vm, pageNumber, frame, dirty);
+    return vm->migrationLatency;
+}
+
+static uint64_t swapPages(VirtualMemory *vm, int first, int second) {
+    PhysicalMemory *mem = vm->physicalMemory;
+    Page *firstPage = getPageFromPageTable(vm->pageTable, first);
+    Page *secondPage = getPageFromPageTable(vm->pageTable, second);
+    int firstFrame = getPageFrameNumber(firstPage);
+    int secondFrame = getPageFrameNumber(secondPage);
+    int firstDirty = isPageDirty(firstPage);
+    int secondDirty = isPageDirty(secondPage);
+    char buffer[FRAME_SIZE];
+    memcpy(buffer, getPhysicalMemoryAtIndex(mem, firstFrame), FRAME_SIZE);
+    memcpy(getPhysicalMemoryAtIndex(mem, firstFrame), getPhysicalMemoryAtIndex(mem, secondFrame), FRAME_SIZE);
+    memcpy(getPhysicalMemoryAtIndex(mem, secondFrame), buffer, FRAME_SIZE);
+    unmapPage(vm, first);
+    unmapPage(vm, second);
+    mapPage(vm, second, firstFrame, secondDirty);
+    mapPage(vm, first, secondFrame, firstDirty);
+    return 2 * vm->migrationLatency;
+}
+
+static uint64_t migrateHotPages(VirtualMemory *vm) {
+    // Promote pages that were hot this period one tier up, swapping with
+    // the coldest page there when it is full, then age every counter
+    uint64_t cost = 0;
+    uint8_t moved[NUM_PAGES] = {0};
+    for (int node = 1; node < vm->numNodes; ++node) {
+        for (int i = 0; i < NUM_PAGES; ++i) {
+            Page *page = getPageFromPageTable(vm->pageTable, i);
+            if (moved[i] || !isPageValid(page) || getFrameNode(vm, getPageFrameNumber(page)) != node
+                    || getPageAccessCount(page) < vm->promoteThreshold) continue;
+            int frame = findFreeFrame(vm, node - 1);
+            if (frame != NO_FRAME) {
+                cost += movePage(vm, i, frame);
+            }
+            else {
+                int coldest = -1;
+                for (int j = 0; j < NUM_PAGES; ++j) {
+                    Page *other = getPageFromPageTable(vm->pageTable, j);
+                    if (moved[j] || !isPageValid(other) || getFrameNode(vm, getPageFrameNumber(other)) != node - 1) continue;
+                    if (coldest == -1 || getPageAccessCount(other) < getPageAccessCount(getPageFromPageTable(vm->pageTable, coldest))) coldest = j;
+                }
+                if (coldest == -1 || getPageAccessCount(getPageFromPageTable(vm->pageTable, coldest)) >= getPageAccessCount(page)) continue;
+                cost += swapPages(vm, i, coldest);
+                moved[coldest] = 1;
+                vm->stats.nodeDemotions[node - 1]++;
+            }
+            moved[i] = 1;
+            vm->stats.nodePromotions[node - 1]++;
+        }
+    }
+    for (int i = 0; i < NUM_PAGES; ++i) {
+        Page *page = getPageFromPageTable(vm->pageTable, i);
+        setPageAccessCount(page, getPageAccessCount(page) / 2);
+    }
+    return cost;
+}
+
+static uint64_t loadPage(VirtualMemory *vm, uint8_t pageNumber, char *frame, int *dirty) {
+    if (vm->tier != 0 && loadCompressedPage(vm->tier, pageNumber, frame, dirty)) {
+        // Still a page fault, but served by decompressing instead of disk
+        vm->stats.numTierHits++;
+        vm->stats.tierTimeSaved += (int64_t)vm->faultLatency - (int64_t)vm->decompressLatency;
+        return vm->decompressLatency;
+    }
+    // A store shorter than the address space reads as zeros past its end
+    size_t offset = (size_t)pageNumber * PAGE_SIZE;
+    size_t available = offset < vm->backingStoreSize ? vm->backingStoreSize - offset : 0;
+    if (available > FRAME_SIZE) available = FRAME_SIZE;
+    if (available > 0) memcpy(frame, vm->backingStore + offset, available);
+    memset(frame + available, 0, FRAME_SIZE - available);
+    return vm->faultLatency;
+}
+
+static void mapPage(VirtualMemory *vm, int pageNumber, int frame, int dirty) {
+    PhysicalMemory *mem = vm->physicalMemory;
+    int refs = getPhysicalMemoryFrameRefs(mem, frame);
+    if (refs == 0) {
+        setPhysicalMemoryFramePage(mem, frame, pageNumber);
+        mem->frameLoaded[frame] = vm->clock;
+        vm->stats.framesInUse++;
+    }
+    setPhysicalMemoryFrameRefs(mem, frame, refs + 1);
+    Page *page = getPageFromPageTable(vm->pageTable, pageNumber);
+    setPageDirty(page, dirty);
+    setPageFrameNumber(page, frame);
+    setPageValidation(page, 1);
+    vm->stats.residentPages++;
+    if (vm->stats.residentPages - vm->stats.framesInUse > vm->stats.peakFramesSaved) {
+        vm->stats.peakFramesSaved = vm->stats.residentPages - vm->stats.framesInUse;
+    }
+}
+
+static uint64_t evictPage(VirtualMemory *vm, int victim) {
+    Page *victimPage = getPageFromPageTable(vm->pageTable, victim);
+    uint64_t cost = 0;
+    int writeBack = isPageDirty(victimPage);
+    // A dirty victim kept in the tier is written back only if the tier
+    // pushes it out later
+    if (vm->tier != 0 && compressVictim(vm, victim, getPageFrameNumber(victimPage), writeBack, &cost)) writeBack = 0;
+    if (writeBack) {
+        // The backing store is read only, so write-backs are only counted
+        vm->stats.numWriteBacks++;
+        cost += vm->writeBackLatency;
+    }
+    unmapPage(vm, victim);
+    vm->stats.numEvictions++;
+    return cost;
+}
+
+static void unmapPage(VirtualMemory *vm, int pageNumber) {
+    PhysicalMemory *mem = vm->physicalMemory;
+    Page *page = getPageFromPageTable(vm->pageTable, pageNumber);
+    int frame = getPageFrameNumber(page);
+    setPageDirty(page, 0);
+    setPageValidation(page, 0);
+    invalidateTLBPage(vm->tlb, pageNumber);
+    int refs = getPhysicalMemoryFrameRefs(mem, frame) - 1;
+    setPhysicalMemoryFrameRefs(mem, frame, refs);
+    if (refs == 0) {
+        setPhysicalMemoryFramePage(mem, frame, NO_FRAME);
+        vm->stats.framesInUse--;
+    }
+    vm->stats.residentPages--;
+}
+
+static int compressVictim(VirtualMemory *vm, int victim, int location, int dirty, uint64_t *cost) {
+    CompressedStore result;
+    storeCompressedPage(vm->tier, victim, getPhysicalMemoryAtIndex(vm->physicalMemory, location), dirty, &result);
+    *cost += vm->compressLatency;
+    vm->stats.tierTimeSaved -= (int64_t)vm->compressLatency;
+    // Dirty pages pushed out of the tier finally pay their write-back
+    vm->stats.numTierEvictions += result.evicted;
+    vm->stats.numWriteBacks += result.evictedDirty;
+    *cost += result.evictedDirty * vm->writeBackLatency;
+    vm->stats.tierTimeSaved -= (int64_t)(result.evictedDirty * vm->writeBackLatency);
+    if (!result.stored) {
+        vm->stats.numTierRejects++;
+        return 0;
+    }
+    vm->stats.numTierStores++;
+    vm->stats.tierUncompressedBytes += PAGE_SIZE;
+    vm->stats.tierCompressedBytes += result.size;
+    if (dirty) vm->stats.tierTimeSaved += (int64_t)vm->writeBackLatency;
+    return 1;
+}
+
+static void emitIntervalSample(VirtualMemory *vm) {
+    uint64_t references = getIntervalSamplerReferences(vm->sampler);
+    uint64_t quantum = getIntervalSamplerQuantum(vm->sampler);
+    while (vm->stats.numTranslated >= vm->nextSampleReference) vm->nextSampleReference += references;
+    while (vm->stats.simulatedTime >= vm->nextSampleTime) vm->nextSampleTime += quantum;
+    pushIntervalSample(vm->sampler, &vm->stats);
+}
+
+static uint64_t hashFrame(const char *data) {
+    // FNV-1a, only used to skip most byte comparisons
+    uint64_t hash = 14695981039346656037ULL;
+    for (int i = 0; i < FRAME_SIZE; ++i) {
+        hash = (hash ^ (uint8_t)data[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+static uint64_t alignCheckpointOffset(uint64_t offset) {
+    return (offset + CHECKPOINT_ALIGN - 1) / CHECKPOINT_ALIGN * CHECKPOINT_ALIGN;
+}
+
+static int writeCheckpoint(FILE *fp, VirtualMemory *vm, uint64_t traceOffset) {
+    PhysicalMemory *mem = vm->physicalMemory;
+    TLB *tlb = vm->tlb;
+    CheckpointHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    h.version = CHECKPOINT_VERSION;
+    h.headerSize = sizeof(CheckpointHeader);
+    h.policy = vm->policy;
+    h.numFrames = mem->numFrames;
+    h.TLBSize = tlb->size;
+    h.TLBCounter = tlb->counter;
+    h.frameCounter = vm->frameCounter;
+    h.fifoHand = vm->fifoHand;
+    h.residentPages = vm->stats.residentPages;
+    h.clock = vm->clock;
+    h.TLBLatency = vm->TLBLatency;
+    h.memoryLatency = vm->memoryLatency;
+    h.faultLatency = vm->faultLatency;
+    h.writeBackLatency = vm->writeBackLatency;
+    h.traceOffset = traceOffset;
+    h.numTranslated = vm->stats.numTranslated;
+    h.numPageFaults = vm->stats.numPageFaults;
+    h.numTLBhits = vm->stats.numTLBhits;
+    h.numEvictions = vm->stats.numEvictions;
+    h.numWriteBacks = vm->stats.numWriteBacks;
+    h.simulatedTime = vm->stats.simulatedTime;
+    h.compressedPoolBytes = vm->tier != 0 ? getCompressedTierCapacity(vm->tier) : 0;
+    h.compressLatency = vm->compressLatency;
+    h.decompressLatency = vm->decompressLatency;
+    h.numTierStores = vm->stats.numTierStores;
+    h.numTierRejects = vm->stats.numTierRejects;
+    h.numTierHits = vm->stats.numTierHits;
+    h.numTierEvictions = vm->stats.numTierEvictions;
+    h.tierUncompressedBytes = vm->stats.tierUncompressedBytes;
+    h.tierCompressedBytes = vm->stats.tierCompressedBytes;
+    h.tierTimeSaved = vm->stats.tierTimeSaved;
+    h.deduplicate = vm->deduplicate;
+    h.peakFramesSaved = vm->stats.peakFramesSaved;
+    h.numMergedPages = vm->stats.numMergedPages;
+    h.numCopyOnWrites = vm->stats.numCopyOnWrites;
+    h.numNodes = vm->numNodes;
+    h.placement = vm->placement;
+    for (int i = 0; i < vm->numNodes; ++i) {
+        h.nodeFrames[i] = vm->numNodes > 1 ? vm->nodeStart[i + 1] - vm->nodeStart[i] : 0;
+        h.nodeLatency[i] = vm->nodeLatency[i];
+    }
+    h.nextNode = vm->nextNode;
+    h.promoteThreshold = vm->promoteThreshold;
+    h.migrationPeriod = vm->migrationPeriod;
+    h.migrationLatency = vm->migrationLatency;
+    h.nextMigration = vm->nextMigration;
+    h.memoryAccessTime = vm->stats.memoryAccessTime;
+    for (int i = 0; i < VMM_MAX_NODES; ++i) {
+        h.nodeAccesses[i] = vm->stats.nodeAccesses[i];
+        h.nodePromotions[i] = vm->stats.nodePromotions[i];
+        h.nodeDemotions[i] = vm->stats.nodeDemotions[i];
+    }
+    h.pageTableOffset = sizeof(CheckpointHeader);
+    h.framesOffset = h.pageTableOffset + sizeof(CheckpointPage) * NUM_PAGES;
+    h.TLBOffset = h.framesOffset + sizeof(CheckpointFrame) * mem->numFrames;
+    h.framePagesOffset = h.TLBOffset + sizeof(CheckpointTLBNode) * tlb->size;
+    h.memoryOffset = alignCheckpointOffset(h.framePagesOffset + sizeof(int32_t) * mem->numFrames);
+    h.tierOffset = h.memoryOffset + (uint64_t)mem->numFrames * FRAME_SIZE;
+    h.tierSize = vm->tier != 0 ? getCompressedTierImageSize(vm->tier) : 0;
+    h.fileSize = h.tierOffset + h.tierSize;
+    if (fwrite(&h, sizeof(h), 1, fp) != 1) return 0;
+
+    for (int i = 0; i < NUM_PAGES; ++i) {
+        Page *page = getPageFromPageTable(vm->pageTable, i);
+        CheckpointPage entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.isValid = isPageValid(page);
+        entry.isDirty = isPageDirty(page);
+        entry.frameNumber = getPageFrameNumber(page);
+        entry.lastUsed = getPageLastUsed(page);
+        entry.accessCount = getPageAccessCount(page);
+        if (fwrite(&entry, sizeof(entry), 1, fp) != 1) return 0;
+    }
+    for (int i = 0; i < mem->numFrames; ++i) {
+        CheckpointFrame entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.loaded = mem->frameLoaded[i];
+        entry.isMergeable = mem->frameMergeable[i];
+        if (fwrite(&entry, sizeof(entry), 1, fp) != 1) return 0;
+    }
+    for (int i = 0; i < tlb->size; ++i) {
+        TLBNode *n = tlb->nodes[i];
+        CheckpointTLBNode entry = { isTLBNodeValid(n), n->pageNumber, n->frameNumber, 0 };
+        if (fwrite(&entry, sizeof(entry), 1, fp) != 1) return 0;
+    }
+    for (int i = 0; i < mem->numFrames; ++i) {
+        int32_t owner = getPhysicalMemoryFramePage(mem, i);
+        if (fwrite(&owner, sizeof(owner), 1, fp) != 1) return 0;
+    }
+    static const char padding[CHECKPOINT_ALIGN];
+    uint64_t written = h.framePagesOffset + sizeof(int32_t) * mem->numFrames;
+    if (fwrite(padding, 1, h.memoryOffset - written, fp) != h.memoryOffset - written) return 0;
+    for (int i = 0; i < mem->numFrames; ++i) {
+        if (fwrite(getPhysicalMemoryAtIndex(mem, i), 1, FRAME_SIZE, fp) != FRAME_SIZE) return 0;
+    }
+    if (vm->tier != 0 && !writeCompressedTier(fp, vm->tier)) return 0;
+    return 1;
+}
+
+static int isCheckpointRange(const CheckpointHeader *h, uint64_t offset, uint64_t size) {
+    return offset <= h->fileSize && size <= h->fileSize - offset;
+}
+
+static int isCheckpointConsistent(const CheckpointHeader *h, const char *base) {
+    // Every page, frame and TLB entry must point inside the tables they
+    // index before any of them is trusted
+    const CheckpointPage *pages = (const CheckpointPage *)(base + h->pageTableOffset);
+    const CheckpointTLBNode *nodes = (const CheckpointTLBNode *)(base + h->TLBOffset);
+    const int32_t *framePages = (const int32_t *)(base + h->framePagesOffset);
+    int refs[VMM_MAX_FRAMES] = {0};
+    int residentPages = 0;
+    for (int i = 0; i < NUM_PAGES; ++i) {
+        if (pages[i].isValid > 1 || pages[i].isDirty > 1) return 0;
+        if (!pages[i].isValid) continue;
+        if (pages[i].frameNumber >= h->numFrames) return 0;
+        refs[pages[i].frameNumber]++;
+        residentPages++;
+    }
+    if (residentPages != h->residentPages) return 0;
+    for (int i = 0; i < h->numFrames; ++i) {
+        if (framePages[i] < NO_FRAME || framePages[i] >= NUM_PAGES) return 0;
+        if ((refs[i] == 0) != (framePages[i] == NO_FRAME)) return 0;
+        if (!h->deduplicate && refs[i] > 1) return 0;
+        if (!h->deduplicate && refs[i] == 1 && pages[framePages[i]].frameNumber != i) return 0;
+        // Flat pools hand out frames from frameCounter on without looking
+        if (h->numNodes == 1 && !h->deduplicate && i >= h->frameCounter && refs[i] > 0) return 0;
+    }
+    for (int i = 0; i < h->TLBSize; ++i) {
+        if (nodes[i].isValid > 1) return 0;
+        if (!nodes[i].isValid) continue;
+        const CheckpointPage *page = &pages[nodes[i].pageNumber];
+        if (nodes[i].frameNumber >= h->numFrames || !page->isValid || page->frameNumber != nodes[i].frameNumber) return 0;
+    }
+    return 1;
+}
@@ -0,0 +1,135 @@
+#ifndef VMM_H
+#define VMM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "profile.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Global Constants */
+#define VMM_API_VERSION     2   // bump whenever a public struct changes layout
+#define VMM_PAGE_SIZE       256
+#define VMM_NUM_PAGES       256
+#define VMM_FRAME_SIZE      256
+#define VMM_MAX_FRAMES      256
+#define VMM_MAX_TLB_SIZE    256
+#define VMM_BATCH_SIZE      64
+#define VMM_MAX_NODES       4
+#define VMM_BACKING_STORE   "./BACKING_STORE.bin"
+#define VMM_WRITE_FLAG      (1ULL << 63)
+
+/* translateAddress Outcomes */
+#define VMM_PAGE_FAULT      0x1
+#define VMM_TLB_HIT         0x2
+
+/* Replacement Policies */
+typedef enum ReplacementPolicy {
+    FIFO_REPLACEMENT,
+    LRU_REPLACEMENT
+} ReplacementPolicy;
+
+/* Placement Policies across memory nodes */
+typedef enum PlacementPolicy {
+    FIRST_TOUCH_PLACEMENT,
+    INTERLEAVE_PLACEMENT,
+    TIERED_PLACEMENT
+} PlacementPolicy;
+
+/* Struct Type Prototypes */
+typedef struct VirtualMemory VirtualMemory;
+typedef struct IntervalSampler IntervalSampler;
+
+// Both structs start with their size, which callers set to sizeof before
+// handing them to the library, so the library never reads or writes past
+// the layout the caller was compiled against. New fields only ever go on
+// the end.
+typedef struct VirtualMemoryConfig {
+    uint32_t size;
+    ReplacementPolicy policy;
+    int numFrames;
+    int TLBSize;
+    const char *backingStorePath;
+    uint64_t TLBLatency;        // simulated ns per TLB lookup
+    uint64_t memoryLatency;     // simulated ns per memory access or table walk
+    uint64_t faultLatency;      // simulated ns to service a page fault
+    uint64_t writeBackLatency;  // simulated ns to write a dirty victim back
+    size_t compressedPoolBytes; // compressed tier for evicted pages, 0 disables it
+    uint64_t compressLatency;   // simulated ns to compress a victim into the tier
+    uint64_t decompressLatency; // simulated ns to serve a fault from the tier
+    int deduplicate;            // share one frame between pages with equal contents
+    int numNodes;               // memory nodes, 1 keeps a flat frame pool
+    int nodeFrames[VMM_MAX_NODES];          // frames per node, summing to numFrames
+    uint64_t nodeLatency[VMM_MAX_NODES];    // simulated ns per access to each node
+    PlacementPolicy placement;
+    uint64_t migrationPeriod;   // references between hot page scans when tiered
+    uint32_t promoteThreshold;  // accesses within a period that make a page hot
+    uint64_t migrationLatency;  // simulated ns to move a page between nodes
+} VirtualMemoryConfig;
+
+typedef struct VirtualMemoryStatistics {
+    uint32_t size;
+    uint64_t numTranslated;
+    uint64_t numPageFaults;
+    uint64_t numTLBhits;
+    uint64_t numEvictions;
+    uint64_t numWriteBacks;
+    uint64_t simulatedTime;
+    int residentPages;
+    uint64_t numTierStores;     // victims kept in the compressed tier
+    uint64_t numTierRejects;    // victims that did not compress or fit
+    uint64_t numTierHits;       // faults served from the compressed tier
+    uint64_t numTierEvictions;  // compressed pages pushed out to make room
+    uint64_t tierUncompressedBytes;
+    uint64_t tierCompressedBytes;
+    int64_t tierTimeSaved;      // simulated ns saved against having no tier
+    uint64_t numMergedPages;    // faults mapped onto an identical resident frame
+    uint64_t numCopyOnWrites;   // writes that had to unshare a frame first
+    int framesInUse;
+    int peakFramesSaved;        // most resident pages beyond framesInUse
+    uint64_t memoryAccessTime;  // simulated ns spent on the data accesses themselves
+    uint64_t nodeAccesses[VMM_MAX_NODES];
+    uint64_t nodePromotions[VMM_MAX_NODES]; // pages moved up into each node
+    uint64_t nodeDemotions[VMM_MAX_NODES];  // pages moved down out of each node
+} VirtualMemoryStatistics;
+
+/* Smallest struct sizes the library accepts, the layouts of API version 2 */
+#define VMM_CONFIG_MIN_SIZE     (offsetof(VirtualMemoryConfig, migrationLatency) + sizeof(uint64_t))
+#define VMM_STATISTICS_MIN_SIZE (offsetof(VirtualMemoryStatistics, nodeDemotions) + sizeof(uint64_t) * VMM_MAX_NODES)
+
+/* VirtualMemoryConfig Function Prototypes */
+int initVirtualMemoryConfig(VirtualMemoryConfig *, ReplacementPolicy);
+
+/* VirtualMemory Function Prototypes */
+VirtualMemory *newVirtualMemory(const VirtualMemoryConfig *);
+int translateAddress(VirtualMemory *, uint64_t, uint32_t *, int *);
+size_t translateBatch(VirtualMemory *, const uint64_t *, size_t, uint32_t *, int *);
+size_t translateRun(VirtualMemory *, uint64_t, size_t, uint32_t *);
+int getVirtualMemoryValue(VirtualMemory *, uint32_t, int *);
+int getVirtualMemoryStatistics(VirtualMemory *, VirtualMemoryStatistics *);
+int getVirtualMemoryConfig(VirtualMemory *, VirtualMemoryConfig *);
+void setVirtualMemoryProfile(VirtualMemory *, Profile *);
+void setVirtualMemorySampler(VirtualMemory *, IntervalSampler *);
+void sampleVirtualMemory(VirtualMemory *);
+int saveVirtualMemory(VirtualMemory *, const char *, uint64_t);
+VirtualMemory *restoreVirtualMemory(const char *, const char *, uint64_t *);
+void freeVirtualMemory(VirtualMemory *);
+
+/* Function Prototypes */
+const char *getReplacementPolicyName(ReplacementPolicy);
+const char *getPlacementPolicyName(PlacementPolicy);
+int parsePlacementPolicy(const char *, PlacementPolicy *);
+void printStatistics(FILE *, const VirtualMemoryStatistics *);
+void printTierStatistics(FILE *, const VirtualMemoryStatistics *);
+void printDedupStatistics(FILE *, const VirtualMemoryStatistics *, const VirtualMemoryStatistics *);
+void printNodeStatistics(FILE *, const VirtualMemoryStatistics *, const VirtualMemoryStatistics *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,158 @@
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vmm.h"
+#include "workload.h"
+
+
+/* Global Constants */
+#define ADDRESS_SPACE       (VMM_NUM_PAGES * VMM_PAGE_SIZE)
+#define NUM_PAGES           VMM_NUM_PAGES
+#define PAGE_SIZE           VMM_PAGE_SIZE
+
+/* Function Prototypes */
+static uint64_t nextRandom(Workload *);
+static int nextZipfRank(Workload *);
+static uint64_t nextAddress(Workload *);
+
+
+/********** WorkloadConfig Definitions **********/
+
+void initWorkloadConfig(WorkloadConfig *config, WorkloadType type) {
+    assert(config != 0);
+    config->type = type;
+    config->seed = 42;
+    config->workingSet = 160;
+    config->zipfExponent = 0.99;
+    config->stride = 4 * PAGE_SIZE + 8;
+    config->phaseLength = 100000;
+}
+
+
+/********** Workload Definitions **********/
+
+typedef struct Workload {
+    WorkloadConfig config;
+    uint64_t state;
+    uint64_t counter;
+    int phaseBase;
+    double zipfCDF[NUM_PAGES];
+    uint8_t permutation[NUM_PAGES];
+} Workload;
+
+Workload *newWorkload(const WorkloadConfig *config) {
+    assert(config != 0);
+    assert(config->workingSet > 0 && config->workingSet <= NUM_PAGES);
+    assert(config->phaseLength > 0);
+    Workload *w = malloc(sizeof(Workload));
+    w->config = *config;
+    w->state = config->seed ? config->seed : 1;
+    w->counter = 0;
+    w->phaseBase = 0;
+    // Hot zipf ranks are scattered over the address space
+    for (int i = 0; i < NUM_PAGES; ++i) {
+        w->permutation[i] = i;
+    }
+    for (int i = NUM_PAGES - 1; i > 0; --i) {
+        int j = nextRandom(w) % (i + 1);
+        uint8_t tmp = w->permutation[i];
+        w->permutation[i] = w->permutation[j];
+        w->permutation[j] = tmp;
+    }
+    double sum = 0;
+    for (int i = 0; i < NUM_PAGES; ++i) {
+        sum += 1.0 / pow(i + 1, config->zipfExponent);
+        w->zipfCDF[i] = sum;
+    }
+    for (int i = 0; i < NUM_PAGES; ++i) {
+        w->zipfCDF[i] /= sum;
+    }
+    return w;
+}
+
+void fillWorkload(Workload *w, uint64_t *addresses, size_t n) {
+    assert(w != 0);
+    assert(addresses != 0 || n == 0);
+    for (size_t i = 0; i < n; ++i) {
+        addresses[i] = nextAddress(w);
+        w->counter++;
+    }
+}
+
+void freeWorkload(Workload *w) {
+    assert(w != 0);
+    free(w);
+}
+
+
+/*********** Function Definitions ***********/
+
+static const char *workloadNames[NUM_WORKLOADS] = {
+    "uniform", "zipf", "sequential", "loop", "phase", "strided"
+};
+
+const char *getWorkloadName(WorkloadType type) {
+    assert(type >= 0 && type < NUM_WORKLOADS);
+    return workloadNames[type];
+}
+
+int parseWorkloadType(const char *name, WorkloadType *type) {
+    assert(name != 0);
+    assert(type != 0);
+    for (int i = 0; i < NUM_WORKLOADS; ++i) {
+        if (strcmp(name, workloadNames[i]) == 0) {
+            *type = i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static uint64_t nextRandom(Workload *w) {
+    // xorshift64*
+    w->state ^= w->state >> 12;
+    w->state ^= w->state << 25;
+    w->state ^= w->state >> 27;
+    return w->state * 0x2545F4914F6CDD1DULL;
+}
+
+static int nextZipfRank(Workload *w) {
+    double u = (nextRandom(w) >> 11) * (1.0 / 9007199254740992.0);
+    int lo = 0;
+    int hi = NUM_PAGES - 1;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (w->zipfCDF[mid] < u) lo = mid + 1;
+        else                     hi = mid;
+    }
+    return lo;
+}
+
+static uint64_t nextAddress(Workload *w) {
+    WorkloadConfig *c = &w->config;
+    uint64_t offset = nextRandom(w) % PAGE_SIZE;
+    switch (c->type) {
+        case UNIFORM_WORKLOAD:
+            return nextRandom(w) % ADDRESS_SPACE;
+        case ZIPF_WORKLOAD:
+            return (uint64_t)w->permutation[nextZipfRank(w)] * PAGE_SIZE + offset;
+        case SEQUENTIAL_WORKLOAD:
+            // One reference per 64 byte line, scanning the whole space
+            return (w->counter * 64) % ADDRESS_SPACE;
+        case LOOP_WORKLOAD:
+            return (w->counter % c->workingSet) * PAGE_SIZE + offset;
+        case PHASE_WORKLOAD:
+            if (w->counter % c->phaseLength == 0) {
+                w->phaseBase = nextRandom(w) % NUM_PAGES;
+            }
+            return ((w->phaseBase + nextRandom(w) % c->workingSet) % NUM_PAGES) * PAGE_SIZE + offset;
+        case STRIDED_WORKLOAD:
+            return (w->counter * c->stride) % ADDRESS_SPACE;
+        default:
+            assert(0);
+    }
+    return 0;
+}
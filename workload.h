@@ -0,0 +1,42 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Workload Types */
+typedef enum WorkloadType {
+    UNIFORM_WORKLOAD,
+    ZIPF_WORKLOAD,
+    SEQUENTIAL_WORKLOAD,
+    LOOP_WORKLOAD,
+    PHASE_WORKLOAD,
+    STRIDED_WORKLOAD,
+    NUM_WORKLOADS
+} WorkloadType;
+
+/* Struct Type Prototypes */
+typedef struct Workload Workload;
+
+typedef struct WorkloadConfig {
+    WorkloadType type;
+    uint64_t seed;
+    int workingSet;         // pages touched by loop and phase workloads
+    double zipfExponent;    // skew of the zipf workload
+    int stride;             // bytes between strided references
+    uint64_t phaseLength;   // references per phase of the phase workload
+} WorkloadConfig;
+
+/* WorkloadConfig Function Prototypes */
+void initWorkloadConfig(WorkloadConfig *, WorkloadType);
+
+/* Workload Function Prototypes */
+Workload *newWorkload(const WorkloadConfig *);
+void fillWorkload(Workload *, uint64_t *, size_t);
+void freeWorkload(Workload *);
+
+/* Function Prototypes */
+const char *getWorkloadName(WorkloadType);
+int parseWorkloadType(const char *, WorkloadType *);
+
+#endif
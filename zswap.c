@@ -0,0 +1,400 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vmm.h"
+#include "zswap.h"
+
+
+/* Global Constants */
+#define NUM_PAGES           VMM_NUM_PAGES
+#define PAGE_SIZE           VMM_PAGE_SIZE
+#define NUM_CLASSES         ((PAGE_SIZE - 1) / ZSWAP_CLASS_SIZE)
+#define MIN_MATCH           3
+#define MAX_OFFSET          255
+#define HASH_BITS           6
+
+/* Struct Type Prototypes */
+typedef struct CompressedEntry CompressedEntry;
+typedef struct SizeClass SizeClass;
+typedef struct TierImageHeader TierImageHeader;
+typedef struct TierImageEntry TierImageEntry;
+
+/* Function Prototypes */
+static void putCompressedPage(CompressedTier *, int, const uint8_t *, size_t, int, CompressedStore *);
+static long allocateSlot(CompressedTier *, int, CompressedStore *);
+static void releaseEntry(CompressedTier *, int);
+static size_t getStoredBytes(CompressedTier *);
+static void compactArena(CompressedTier *);
+static int emitSequence(uint8_t *, size_t *, size_t, const uint8_t *, size_t, size_t, size_t);
+static uint32_t hashMatch(const uint8_t *);
+
+
+/********** CompressedTier Definitions **********/
+
+typedef struct CompressedEntry {
+    int isStored;
+    int isDirty;
+    int sizeClass;
+    long slot;
+    size_t size;
+    uint64_t sequence;
+} CompressedEntry;
+
+typedef struct SizeClass {
+    long freeSlots[NUM_PAGES];
+    int numFree;
+} SizeClass;
+
+// zsmalloc-style pool: one arena carved into fixed size slots on demand
+// with a free list per size class. Slots are recycled within their class
+// first; when neither a free slot nor the uncarved tail fits, the stored
+// entries are packed to the front to hand the free slots of every class
+// back to the arena, evicting the oldest entries overall until the new
+// one fits. Pages that do not compress below the largest class are
+// rejected.
+typedef struct CompressedTier {
+    size_t capacity;
+    size_t used;
+    uint8_t *arena;
+    SizeClass classes[NUM_CLASSES];
+    CompressedEntry entries[NUM_PAGES];
+    uint64_t sequence;
+} CompressedTier;
+
+CompressedTier *newCompressedTier(size_t capacity) {
+    assert(capacity > 0);
+    CompressedTier *tier = calloc(1, sizeof(CompressedTier));
+    tier->capacity = capacity;
+    tier->arena = malloc(capacity);
+    return tier;
+}
+
+void storeCompressedPage(CompressedTier *tier, int page, const char *data, int dirty, CompressedStore *result) {
+    assert(tier != 0);
+    assert(data != 0);
+    uint8_t buffer[ZSWAP_MAX_SIZE];
+    size_t size = compressPage((const uint8_t *)data, PAGE_SIZE, buffer, sizeof(buffer));
+    putCompressedPage(tier, page, buffer, size, dirty, result);
+}
+
+int loadCompressedPage(CompressedTier *tier, int page, char *data, int *dirty) {
+    assert(tier != 0);
+    assert(page >= 0 && page < NUM_PAGES);
+    assert(data != 0);
+    CompressedEntry *entry = &tier->entries[page];
+    if (!entry->isStored) return 0;
+    size_t n = decompressPage(tier->arena + entry->slot, entry->size, (uint8_t *)data, PAGE_SIZE);
+    int isLoaded = n == PAGE_SIZE;
+    if (isLoaded && dirty != 0) *dirty = entry->isDirty;
+    // Exclusive tier: the page lives in RAM again, or comes from the
+    // backing store if its entry no longer decodes
+    releaseEntry(tier, page);
+    return isLoaded;
+}
+
+size_t getCompressedTierCapacity(CompressedTier *tier) {
+    assert(tier != 0);
+    return tier->capacity;
+}
+
+// The checkpoint image keeps the arena layout and free list order as they
+// are, so a restored tier makes the same eviction choices as the original
+typedef struct TierImageHeader {
+    uint64_t capacity;
+    uint64_t used;
+    uint64_t sequence;
+    int32_t numFree[NUM_CLASSES];
+    int32_t reserved;
+} TierImageHeader;
+
+typedef struct TierImageEntry {
+    uint8_t isStored;
+    uint8_t isDirty;
+    uint8_t sizeClass;
+    uint8_t reserved;
+    uint32_t size;
+    int64_t slot;
+    uint64_t sequence;
+} TierImageEntry;
+
+size_t getCompressedTierImageSize(CompressedTier *tier) {
+    assert(tier != 0);
+    return sizeof(TierImageHeader) + sizeof(TierImageEntry) * NUM_PAGES
+        + sizeof(int64_t) * NUM_PAGES * NUM_CLASSES + tier->used;
+}
+
+int writeCompressedTier(FILE *fp, CompressedTier *tier) {
+    assert(fp != 0);
+    assert(tier != 0);
+    TierImageHeader h;
+    memset(&h, 0, sizeof(h));
+    h.capacity = tier->capacity;
+    h.used = tier->used;
+    h.sequence = tier->sequence;
+    for (int i = 0; i < NUM_CLASSES; ++i) h.numFree[i] = tier->classes[i].numFree;
+    if (fwrite(&h, sizeof(h), 1, fp) != 1) return 0;
+    for (int i = 0; i < NUM_PAGES; ++i) {
+        CompressedEntry *entry = &tier->entries[i];
+        TierImageEntry image = { entry->isStored, entry->isDirty, entry->sizeClass, 0, entry->size, entry->slot, entry->sequence };
+        if (fwrite(&image, sizeof(image), 1, fp) != 1) return 0;
+    }
+    for (int i = 0; i < NUM_CLASSES; ++i) {
+        int64_t slots[NUM_PAGES] = {0};
+        for (int j = 0; j < tier->classes[i].numFree; ++j) slots[j] = tier->classes[i].freeSlots[j];
+        if (fwrite(slots, sizeof(slots), 1, fp) != 1) return 0;
+    }
+    return fwrite(tier->arena, 1, tier->used, fp) == tier->used;
+}
+
+CompressedTier *readCompressedTier(const void *image, size_t size) {
+    assert(image != 0);
+    const TierImageHeader *h = image;
+    if (size < sizeof(TierImageHeader) || h->capacity == 0 || h->used > h->capacity) return 0;
+    size_t entriesOffset = sizeof(TierImageHeader);
+    size_t slotsOffset = entriesOffset + sizeof(TierImageEntry) * NUM_PAGES;
+    size_t arenaOffset = slotsOffset + sizeof(int64_t) * NUM_PAGES * NUM_CLASSES;
+    if (size != arenaOffset + h->used) return 0;
+    const char *base = image;
+    const TierImageEntry *entries = (const TierImageEntry *)(base + entriesOffset);
+    const int64_t *slots = (const int64_t *)(base + slotsOffset);
+    // Every slot has to lie inside the carved part of the arena and decode
+    // back to a whole page
+    uint8_t page[PAGE_SIZE];
+    for (int i = 0; i < NUM_PAGES; ++i) {
+        const TierImageEntry *e = &entries[i];
+        if (!e->isStored) continue;
+        size_t slotSize = (size_t)(e->sizeClass + 1) * ZSWAP_CLASS_SIZE;
+        if (e->sizeClass >= NUM_CLASSES || e->size == 0 || e->size > slotSize
+                || e->slot < 0 || (uint64_t)e->slot + slotSize > h->used) return 0;
+        const uint8_t *data = (const uint8_t *)base + arenaOffset + e->slot;
+        if (decompressPage(data, e->size, page, PAGE_SIZE) != PAGE_SIZE) return 0;
+    }
+    for (int i = 0; i < NUM_CLASSES; ++i) {
+        size_t slotSize = (size_t)(i + 1) * ZSWAP_CLASS_SIZE;
+        if (h->numFree[i] < 0 || h->numFree[i] > NUM_PAGES) return 0;
+        for (int j = 0; j < h->numFree[i]; ++j) {
+            int64_t slot = slots[i * NUM_PAGES + j];
+            if (slot < 0 || (uint64_t)slot + slotSize > h->used) return 0;
+        }
+    }
+
+    CompressedTier *tier = newCompressedTier(h->capacity);
+    tier->used = h->used;
+    tier->sequence = h->sequence;
+    for (int i = 0; i < NUM_PAGES; ++i) {
+        const TierImageEntry *e = &entries[i];
+        CompressedEntry *entry = &tier->entries[i];
+        entry->isStored = e->isStored != 0;
+        entry->isDirty = e->isDirty;
+        entry->sizeClass = e->sizeClass;
+        entry->slot = (long)e->slot;
+        entry->size = e->size;
+        entry->sequence = e->sequence;
+    }
+    for (int i = 0; i < NUM_CLASSES; ++i) {
+        tier->classes[i].numFree = h->numFree[i];
+        for (int j = 0; j < h->numFree[i]; ++j) tier->classes[i].freeSlots[j] = (long)slots[i * NUM_PAGES + j];
+    }
+    memcpy(tier->arena, base + arenaOffset, h->used);
+    return tier;
+}
+
+void freeCompressedTier(CompressedTier *tier) {
+    assert(tier != 0);
+    free(tier->arena);
+    free(tier);
+}
+
+
+/*********** Function Definitions ***********/
+
+size_t compressPage(const uint8_t *src, size_t n, uint8_t *dst, size_t capacity) {
+    // LZ4-like sequences: a token with literal and match length nibbles,
+    // length extension bytes for nibbles of 15, the literals, then a one
+    // byte match offset. The last sequence carries literals only.
+    assert(src != 0);
+    assert(dst != 0);
+    int table[1 << HASH_BITS];
+    for (int i = 0; i < (1 << HASH_BITS); ++i) table[i] = -1;
+    size_t ip = 0;
+    size_t op = 0;
+    size_t anchor = 0;
+    while (ip + MIN_MATCH <= n) {
+        uint32_t h = hashMatch(src + ip);
+        int candidate = table[h];
+        table[h] = (int)ip;
+        if (candidate < 0 || ip - candidate > MAX_OFFSET || memcmp(src + candidate, src + ip, MIN_MATCH) != 0) {
+            ip++;
+            continue;
+        }
+        size_t length = MIN_MATCH;
+        while (ip + length < n && src[candidate + length] == src[ip + length]) length++;
+        if (!emitSequence(dst, &op, capacity, src + anchor, ip - anchor, ip - candidate, length)) return 0;
+        ip += length;
+        anchor = ip;
+    }
+    if (!emitSequence(dst, &op, capacity, src + anchor, n - anchor, 0, 0)) return 0;
+    return op;
+}
+
+size_t decompressPage(const uint8_t *src, size_t n, uint8_t *dst, size_t capacity) {
+    assert(src != 0);
+    assert(dst != 0);
+    size_t ip = 0;
+    size_t op = 0;
+    while (ip < n) {
+        uint8_t token = src[ip++];
+        size_t literals = token >> 4;
+        if (literals == 15) {
+            uint8_t more;
+            do {
+                if (ip >= n) return 0;
+                more = src[ip++];
+                literals += more;
+            } while (more == 255);
+        }
+        if (ip + literals > n || op + literals > capacity) return 0;
+        memcpy(dst + op, src + ip, literals);
+        ip += literals;
+        op += literals;
+        if (ip == n) break;
+        size_t offset = src[ip++];
+        size_t length = (token & 15) + MIN_MATCH;
+        if ((token & 15) == 15) {
+            uint8_t more;
+            do {
+                if (ip >= n) return 0;
+                more = src[ip++];
+                length += more;
+            } while (more == 255);
+        }
+        if (offset == 0 || offset > op || op + length > capacity) return 0;
+        // Byte at a time, matches may overlap their own output
+        for (size_t i = 0; i < length; ++i, ++op) {
+            dst[op] = dst[op - offset];
+        }
+    }
+    return op;
+}
+
+static int emitSequence(uint8_t *dst, size_t *op, size_t capacity, const uint8_t *literals, size_t numLiterals, size_t offset, size_t length) {
+    size_t matchCode = offset ? length - MIN_MATCH : 0;
+    size_t need = 1 + numLiterals / 255 + 1 + numLiterals + (offset ? 1 + matchCode / 255 + 1 : 0);
+    if (*op + need > capacity) return 0;
+    uint8_t *p = dst + *op;
+    *p++ = (uint8_t)((numLiterals < 15 ? numLiterals : 15) << 4 | (matchCode < 15 ? matchCode : 15));
+    if (numLiterals >= 15) {
+        size_t rest = numLiterals - 15;
+        for (; rest >= 255; rest -= 255) *p++ = 255;
+        *p++ = (uint8_t)rest;
+    }
+    memcpy(p, literals, numLiterals);
+    p += numLiterals;
+    if (offset) {
+        *p++ = (uint8_t)offset;
+        if (matchCode >= 15) {
+            size_t rest = matchCode - 15;
+            for (; rest >= 255; rest -= 255) *p++ = 255;
+            *p++ = (uint8_t)rest;
+        }
+    }
+    *op = p - dst;
+    return 1;
+}
+
+static void putCompressedPage(CompressedTier *tier, int page, const uint8_t *buffer, size_t size, int dirty, CompressedStore *result) {
+    assert(tier != 0);
+    assert(page >= 0 && page < NUM_PAGES);
+    assert(result != 0);
+    memset(result, 0, sizeof(CompressedStore));
+    result->size = size;
+    if (tier->entries[page].isStored) releaseEntry(tier, page);
+    if (size == 0 || size > NUM_CLASSES * ZSWAP_CLASS_SIZE) return;
+    int sizeClass = (int)((size - 1) / ZSWAP_CLASS_SIZE);
+    long slot = allocateSlot(tier, sizeClass, result);
+    if (slot < 0) return;
+    memcpy(tier->arena + slot, buffer, size);
+    CompressedEntry *entry = &tier->entries[page];
+    entry->isStored = 1;
+    entry->isDirty = dirty;
+    entry->sizeClass = sizeClass;
+    entry->slot = slot;
+    entry->size = size;
+    entry->sequence = tier->sequence++;
+    result->stored = 1;
+}
+
+static long allocateSlot(CompressedTier *tier, int sizeClass, CompressedStore *result) {
+    SizeClass *c = &tier->classes[sizeClass];
+    size_t slotSize = (size_t)(sizeClass + 1) * ZSWAP_CLASS_SIZE;
+    if (slotSize > tier->capacity) return -1;
+    for (;;) {
+        if (c->numFree > 0) return c->freeSlots[--c->numFree];
+        if (tier->used + slotSize <= tier->capacity) {
+            long slot = (long)tier->used;
+            tier->used += slotSize;
+            return slot;
+        }
+        if (getStoredBytes(tier) + slotSize <= tier->capacity) {
+            compactArena(tier);
+            continue;
+        }
+        // Pool is full, push out the oldest entry of any class
+        int oldest = -1;
+        for (int i = 0; i < NUM_PAGES; ++i) {
+            CompressedEntry *entry = &tier->entries[i];
+            if (entry->isStored && (oldest == -1 || entry->sequence < tier->entries[oldest].sequence)) oldest = i;
+        }
+        if (oldest == -1) return -1;
+        result->evicted++;
+        if (tier->entries[oldest].isDirty) result->evictedDirty++;
+        releaseEntry(tier, oldest);
+    }
+}
+
+static void releaseEntry(CompressedTier *tier, int page) {
+    CompressedEntry *entry = &tier->entries[page];
+    SizeClass *c = &tier->classes[entry->sizeClass];
+    c->freeSlots[c->numFree++] = entry->slot;
+    entry->isStored = 0;
+}
+
+static size_t getStoredBytes(CompressedTier *tier) {
+    size_t bytes = 0;
+    for (int i = 0; i < NUM_PAGES; ++i) {
+        if (tier->entries[i].isStored) bytes += (size_t)(tier->entries[i].sizeClass + 1) * ZSWAP_CLASS_SIZE;
+    }
+    return bytes;
+}
+
+static void compactArena(CompressedTier *tier) {
+    // Slide the stored entries down in arena order, which never overlaps a
+    // later entry, and drop every free list with the space they described
+    int order[NUM_PAGES];
+    int count = 0;
+    for (int i = 0; i < NUM_PAGES; ++i) {
+        if (!tier->entries[i].isStored) continue;
+        int j = count++;
+        while (j > 0 && tier->entries[order[j - 1]].slot > tier->entries[i].slot) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+    size_t used = 0;
+    for (int i = 0; i < count; ++i) {
+        CompressedEntry *entry = &tier->entries[order[i]];
+        memmove(tier->arena + used, tier->arena + entry->slot, entry->size);
+        entry->slot = (long)used;
+        used += (size_t)(entry->sizeClass + 1) * ZSWAP_CLASS_SIZE;
+    }
+    for (int i = 0; i < NUM_CLASSES; ++i) tier->classes[i].numFree = 0;
+    tier->used = used;
+}
+
+static uint32_t hashMatch(const uint8_t *p) {
+    uint32_t v = p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16;
+    return (v * 2654435761U) >> (32 - HASH_BITS);
+}
@@ -0,0 +1,46 @@
+#ifndef ZSWAP_H
+#define ZSWAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "vmm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Global Constants */
+#define ZSWAP_CLASS_SIZE    16
+#define ZSWAP_MAX_SIZE      (2 * VMM_PAGE_SIZE)
+
+/* Struct Type Prototypes */
+typedef struct CompressedTier CompressedTier;
+
+typedef struct CompressedStore {
+    int stored;         // 0 if the page was incompressible or no slot could be freed
+    size_t size;        // compressed size in bytes, 0 if it did not compress
+    int evicted;        // older entries pushed out to make room
+    int evictedDirty;   // of those, entries that still needed writing back
+} CompressedStore;
+
+/* CompressedTier Function Prototypes */
+CompressedTier *newCompressedTier(size_t);
+void storeCompressedPage(CompressedTier *, int, const char *, int, CompressedStore *);
+int loadCompressedPage(CompressedTier *, int, char *, int *);
+size_t getCompressedTierCapacity(CompressedTier *);
+size_t getCompressedTierImageSize(CompressedTier *);
+int writeCompressedTier(FILE *, CompressedTier *);
+CompressedTier *readCompressedTier(const void *, size_t);
+void freeCompressedTier(CompressedTier *);
+
+/* Function Prototypes */
+size_t compressPage(const uint8_t *, size_t, uint8_t *, size_t);
+size_t decompressPage(const uint8_t *, size_t, uint8_t *, size_t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif